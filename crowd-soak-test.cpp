@@ -0,0 +1,522 @@
+// Crowd soak simulator for RecordTask and FaceDatabase.
+//
+// Enrolls synthetic identities into a scratch face database, then replays a
+// queue of visitors with noisy feature vectors. Each frame is queried like
+// RecognizeTask does and handed to RecordTask::rx_frame as a RecognizeData, the
+// decision is read back from tx_identity and tx_display. The enrolled ids are
+// unknown to PersonService, so they are displayed and deduplicated as visitors;
+// accuracy is counted on the identity of tx_identity.
+//
+// Run it from a scratch directory on the device with face-terminal stopped:
+//   ./crowd-soak-test --identities 50000 --rate 2 --visits 2000
+//
+// Options:
+//   --identities N      enrolled gallery size (default 50000)
+//   --visits N          number of simulated visits (default 1000)
+//   --rate R            visitor arrival rate per second, 0 = no pacing (2)
+//   --fps F             frames per second while a visitor is in front (15)
+//   --frames N          max frames a visitor stays in front (15)
+//   --noise S           per-dimension gaussian noise of each frame (0.03)
+//   --stranger-ratio P  fraction of visits from unenrolled people (0.2)
+//   --mask-ratio P      fraction of visits wearing a mask (0.1)
+//   --db PATH           scratch database (/tmp/crowd-soak/quface)
+//   --seed N            random seed (0)
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QObject>
+
+#include <quface/logger.hpp>
+
+#include "config.hpp"
+#include "record_task.hpp"
+
+#define MICROSECONDS_DIFF(t1, t2) \
+  (std::chrono::duration_cast<std::chrono::microseconds>((t1) - (t2)).count())
+
+namespace suanzi {
+
+struct CrowdOptions {
+  SZ_UINT32 identities = 50000;
+  SZ_UINT32 visits = 1000;
+  float rate = 2;
+  float fps = 15;
+  int frames = 15;
+  float noise = 0.03;
+  float stranger_ratio = 0.2;
+  float mask_ratio = 0.1;
+  std::string db_name = "/tmp/crowd-soak/quface";
+  SZ_UINT32 seed = 0;
+};
+
+struct CrowdReport {
+  int visits = 0;
+  int known_visits = 0;
+  int stranger_visits = 0;
+
+  int decisions = 0;
+  int no_decision = 0;
+  int duplicated = 0;
+
+  int correct_accept = 0;
+  int misidentified = 0;
+  int false_reject = 0;
+  int false_accept = 0;
+  int correct_reject = 0;
+
+  std::vector<float> frame_latency;     // ms per frame, query + record logic
+  std::vector<float> decision_latency;  // ms from first frame to decision
+  std::vector<float> decision_busy;     // ms of query + record logic
+  std::vector<int> decision_frames;
+  std::vector<float> queue_wait;  // s waited in the queue before the door
+
+  double busy_seconds = 0;
+  double wall_seconds = 0;
+
+  long rss_start = 0;
+  long rss_enrolled = 0;
+  long rss_end = 0;
+  SZ_UINT32 unknown_db_size = 0;
+};
+
+class CrowdSimulator : public QObject {
+  Q_OBJECT
+
+ public:
+  CrowdSimulator(const CrowdOptions &opt)
+      : opt_(opt),
+        rng_(opt.seed),
+        normal_(0.f, 1.f),
+        uniform_(0.f, 1.f),
+        frame_idx_(0),
+        decided_(false),
+        duplicated_(false),
+        face_id_(0),
+        buffer_ping_(nullptr),
+        buffer_pang_(nullptr),
+        pingpang_buffer_(nullptr) {}
+  ~CrowdSimulator();
+
+  bool init();
+  void enroll();
+  void run();
+  void report();
+
+ private slots:
+  void rx_identity(uint track_id, uint face_id);
+  void rx_display(PersonData person, bool audio_duplicated,
+                  bool record_duplicated);
+
+ private:
+  void random_feature(FaceFeature &feature);
+  void noisy_feature(const FaceFeature &base, float noise,
+                     FaceFeature &feature);
+  void query(const FaceFeature &feature, bool has_mask, QueryResult &info);
+  void feed_frame(SZ_UINT32 track_id, const FaceFeature &feature,
+                  bool has_mask);
+  void reset_task();
+
+  static void normalize(FaceFeature &feature);
+  static long read_rss();
+  static float percentile(std::vector<float> values, float p);
+
+  CrowdOptions opt_;
+  CrowdReport report_;
+
+  std::mt19937 rng_;
+  std::normal_distribution<float> normal_;
+  std::uniform_real_distribution<float> uniform_;
+
+  std::vector<FaceFeature> gallery_;
+
+  int frame_idx_;
+
+  // set by the signals of the frame just fed
+  bool decided_;
+  bool duplicated_;
+  SZ_UINT32 face_id_;
+
+  QObject *task_;
+  RecognizeData *buffer_ping_, *buffer_pang_;
+  PingPangBuffer<RecognizeData> *pingpang_buffer_;
+  FaceDatabasePtr query_database_, unknown_database_;
+};
+
+}  // namespace suanzi
+
+using namespace suanzi;
+
+CrowdSimulator::~CrowdSimulator() {
+  if (pingpang_buffer_) delete pingpang_buffer_;
+  if (buffer_ping_) delete buffer_ping_;
+  if (buffer_pang_) delete buffer_pang_;
+}
+
+void CrowdSimulator::normalize(FaceFeature &feature) {
+  float norm = 0;
+  for (int k = 0; k < SZ_FEATURE_NUM; k++)
+    norm += feature.value[k] * feature.value[k];
+  norm = std::sqrt(norm);
+  if (norm == 0) return;
+  for (int k = 0; k < SZ_FEATURE_NUM; k++) feature.value[k] /= norm;
+}
+
+long CrowdSimulator::read_rss() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.find("VmRSS:") == 0) return std::stol(line.substr(6));
+  }
+  return 0;
+}
+
+float CrowdSimulator::percentile(std::vector<float> values, float p) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  size_t idx = std::min(values.size() - 1, (size_t)(p * values.size()));
+  return values[idx];
+}
+
+void CrowdSimulator::random_feature(FaceFeature &feature) {
+  for (int k = 0; k < SZ_FEATURE_NUM; k++) feature.value[k] = normal_(rng_);
+  normalize(feature);
+}
+
+void CrowdSimulator::noisy_feature(const FaceFeature &base, float noise,
+                                   FaceFeature &feature) {
+  for (int k = 0; k < SZ_FEATURE_NUM; k++)
+    feature.value[k] = base.value[k] + noise * normal_(rng_);
+  normalize(feature);
+}
+
+bool CrowdSimulator::init() {
+  // Point the gallery and the stranger database to scratch ones before
+  // RecordTask is created, so the production databases are never touched.
+  std::string dir = opt_.db_name.substr(0, opt_.db_name.rfind('/'));
+  mkdir(dir.c_str(), 0755);
+
+  std::string cfg_file = dir + "/config.json";
+  std::string cfg_override_file = dir + "/config.override.json";
+  {
+    json cfg = {{"quface",
+                 {{"db_name", opt_.db_name},
+                  {"unknown_db_name", "_SOAK_UNKNOWN_DB_"}}}};
+    std::ofstream o(cfg_file);
+    o << cfg.dump(2);
+    std::ofstream oo(cfg_override_file);
+    oo << "{}";
+  }
+  if (SZ_RETCODE_OK !=
+      Config::get_instance()->load_from_file(cfg_file, cfg_override_file))
+    return false;
+
+  query_database_ = std::make_shared<FaceDatabase>(opt_.db_name);
+  query_database_->clear();
+  unknown_database_ =
+      std::make_shared<FaceDatabase>(Config::get_quface().unknown_db_name);
+  unknown_database_->clear();
+
+  // snapshots are taken from these, tiny images keep the copies cheap
+  Size size = {64, 64};
+  buffer_ping_ = new RecognizeData(size, size, size, size);
+  buffer_pang_ = new RecognizeData(size, size, size, size);
+  pingpang_buffer_ =
+      new PingPangBuffer<RecognizeData>(buffer_ping_, buffer_pang_);
+
+  // rx_frame is called directly on this thread, so are the signals
+  task_ = (QObject *)RecordTask::get_instance();
+  connect(task_, SIGNAL(tx_identity(uint, uint)), this,
+          SLOT(rx_identity(uint, uint)), Qt::DirectConnection);
+  connect(task_, SIGNAL(tx_display(PersonData, bool, bool)), this,
+          SLOT(rx_display(PersonData, bool, bool)), Qt::DirectConnection);
+  reset_task();
+  return true;
+}
+
+void CrowdSimulator::reset_task() {
+  QMetaObject::invokeMethod(task_, "rx_reset", Qt::DirectConnection);
+}
+
+void CrowdSimulator::rx_identity(uint track_id, uint face_id) {
+  face_id_ = face_id;
+}
+
+void CrowdSimulator::rx_display(PersonData person, bool audio_duplicated,
+                                bool record_duplicated) {
+  decided_ = true;
+  duplicated_ = audio_duplicated;
+}
+
+void CrowdSimulator::enroll() {
+  report_.rss_start = read_rss();
+
+  auto start = std::chrono::steady_clock::now();
+  gallery_.resize(opt_.identities);
+  for (SZ_UINT32 i = 0; i < opt_.identities; i++) {
+    random_feature(gallery_[i]);
+    if (SZ_RETCODE_OK != query_database_->add(i + 1, gallery_[i]))
+      SZ_LOG_ERROR("Enroll {} failed", i + 1);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  SZ_UINT32 db_size = 0;
+  query_database_->size(db_size);
+  SZ_LOG_INFO("Enrolled {} identities in {:.1f}s", db_size,
+              MICROSECONDS_DIFF(end, start) / 1e6);
+
+  report_.rss_enrolled = read_rss();
+}
+
+void CrowdSimulator::query(const FaceFeature &feature, bool has_mask,
+                           QueryResult &info) {
+  // Same as RecognizeTask::extract_and_query, minus the extractor
+  static std::vector<QueryResult> results;
+  results.clear();
+
+  if (SZ_RETCODE_OK == query_database_->query(feature, 1, results) &&
+      results.size() > 0) {
+    if (has_mask)
+      info.score = pow((results[0].score - 0.5) * 2, 0.45) / 2 + 0.5;
+    else
+      info.score = results[0].score;
+    info.face_id = results[0].face_id;
+  } else {
+    info.score = 0;
+    info.face_id = 0;
+  }
+}
+
+void CrowdSimulator::feed_frame(SZ_UINT32 track_id, const FaceFeature &feature,
+                                bool has_mask) {
+  // the ping side is filled as RecognizeTask does, rx_frame switches to it
+  RecognizeData *input = pingpang_buffer_->get_ping();
+  input->frame_idx = frame_idx_++;
+  input->capture_clock = std::chrono::steady_clock::now();
+  input->bgr_track_id_ = track_id;
+
+  // no face box, snapshots keep the raw frame
+  input->bgr_face_detected_ = false;
+  input->bgr_face_valid_ = false;
+
+  input->has_person_info = true;
+  input->has_mask = has_mask;
+  input->person_feature = feature;
+  query(feature, has_mask, input->person_info);
+
+  input->has_live = true;
+  input->is_live = true;
+
+  decided_ = false;
+  duplicated_ = false;
+  face_id_ = 0;
+  QMetaObject::invokeMethod(
+      task_, "rx_frame", Qt::DirectConnection,
+      Q_ARG(PingPangBuffer<RecognizeData> *, pingpang_buffer_));
+}
+
+void CrowdSimulator::run() {
+  std::exponential_distribution<double> arrival(opt_.rate > 0 ? opt_.rate : 1);
+
+  auto wall_start = std::chrono::steady_clock::now();
+  double arrival_time = 0;  // s, since wall_start
+  double door_free_time = 0;
+
+  for (SZ_UINT32 v = 0; v < opt_.visits; v++) {
+    bool is_stranger = uniform_(rng_) < opt_.stranger_ratio;
+    bool has_mask = uniform_(rng_) < opt_.mask_ratio;
+
+    SZ_UINT32 true_id = 0;
+    FaceFeature base;
+    if (is_stranger) {
+      random_feature(base);
+      report_.stranger_visits++;
+    } else {
+      true_id = 1 + rng_() % opt_.identities;
+      // per visit offset: lighting, pose, expression ...
+      noisy_feature(gallery_[true_id - 1], opt_.noise / 2, base);
+      report_.known_visits++;
+    }
+    report_.visits++;
+
+    // queue: the next one steps in when the previous one has left the door
+    if (opt_.rate > 0) arrival_time += arrival(rng_);
+    double start_time = std::max(arrival_time, door_free_time);
+    report_.queue_wait.push_back(start_time - arrival_time);
+
+    // FaceTimer resets RecordTask when nobody is in front for a while
+    if (opt_.rate > 0 && start_time - door_free_time > 1) reset_task();
+
+    decided_ = false;
+    float busy_ms = 0;
+    int frame = 0;
+    std::chrono::steady_clock::time_point first_clock;
+    for (; frame < opt_.frames && !decided_; frame++) {
+      if (opt_.rate > 0) {
+        auto due = wall_start + std::chrono::microseconds(
+                                    (long)((start_time + frame / opt_.fps) *
+                                           1e6));
+        std::this_thread::sleep_until(due);
+      }
+
+      FaceFeature feature;
+      noisy_feature(base, opt_.noise, feature);
+
+      auto t1 = std::chrono::steady_clock::now();
+      if (frame == 0) first_clock = t1;
+      // every visit is one track of DetectTask
+      feed_frame(v + 1, feature, has_mask);
+      auto t2 = std::chrono::steady_clock::now();
+
+      float ms = MICROSECONDS_DIFF(t2, t1) / 1000.f;
+      busy_ms += ms;
+      report_.frame_latency.push_back(ms);
+      if (decided_)
+        report_.decision_latency.push_back(
+            MICROSECONDS_DIFF(t2, first_clock) / 1000.f);
+    }
+    door_free_time = start_time + frame / opt_.fps;
+    report_.busy_seconds += busy_ms / 1000;
+
+    if (!decided_) {
+      report_.no_decision++;
+      if (!is_stranger) report_.false_reject++;
+      continue;
+    }
+    report_.decisions++;
+    report_.decision_busy.push_back(busy_ms);
+    report_.decision_frames.push_back(frame);
+    if (duplicated_) report_.duplicated++;
+
+    if (is_stranger) {
+      if (face_id_ == 0)
+        report_.correct_reject++;
+      else
+        report_.false_accept++;
+    } else {
+      if (face_id_ == true_id)
+        report_.correct_accept++;
+      else if (face_id_ == 0)
+        report_.false_reject++;
+      else
+        report_.misidentified++;
+    }
+
+    if ((v + 1) % 100 == 0)
+      SZ_LOG_INFO("visits={} decisions={} rss={}kB", v + 1, report_.decisions,
+                  read_rss());
+  }
+
+  auto wall_end = std::chrono::steady_clock::now();
+  report_.wall_seconds = MICROSECONDS_DIFF(wall_end, wall_start) / 1e6;
+  report_.rss_end = read_rss();
+  unknown_database_->size(report_.unknown_db_size);
+}
+
+void CrowdSimulator::report() {
+  auto &r = report_;
+  auto ratio = [](int n, int total) {
+    return total > 0 ? n * 100.f / total : 0.f;
+  };
+
+  float mean_frames = 0;
+  for (int n : r.decision_frames) mean_frames += n;
+  if (!r.decision_frames.empty()) mean_frames /= r.decision_frames.size();
+
+  SZ_LOG_INFO("==== crowd soak report ====");
+  SZ_LOG_INFO("gallery={} visits={} (known={}, stranger={}) rate={}/s",
+              opt_.identities, r.visits, r.known_visits, r.stranger_visits,
+              opt_.rate);
+  SZ_LOG_INFO("decisions={} no_decision={} duplicated={}", r.decisions,
+              r.no_decision, r.duplicated);
+  SZ_LOG_INFO("decisions/s: busy={:.1f} wall={:.2f}",
+              r.busy_seconds > 0 ? r.decisions / r.busy_seconds : 0,
+              r.wall_seconds > 0 ? r.decisions / r.wall_seconds : 0);
+  SZ_LOG_INFO("frame latency ms: p50={:.2f} p90={:.2f} p99={:.2f} max={:.2f}",
+              percentile(r.frame_latency, 0.5),
+              percentile(r.frame_latency, 0.9),
+              percentile(r.frame_latency, 0.99),
+              percentile(r.frame_latency, 1));
+  SZ_LOG_INFO(
+      "decision latency ms: p50={:.2f} p90={:.2f} p99={:.2f}, frames={:.2f}",
+      percentile(r.decision_latency, 0.5),
+      percentile(r.decision_latency, 0.9),
+      percentile(r.decision_latency, 0.99), mean_frames);
+  SZ_LOG_INFO("decision busy ms: p50={:.2f} p90={:.2f} p99={:.2f}",
+              percentile(r.decision_busy, 0.5),
+              percentile(r.decision_busy, 0.9),
+              percentile(r.decision_busy, 0.99));
+  SZ_LOG_INFO("queue wait s: p50={:.2f} p90={:.2f} max={:.2f}",
+              percentile(r.queue_wait, 0.5), percentile(r.queue_wait, 0.9),
+              percentile(r.queue_wait, 1));
+  SZ_LOG_INFO("known: correct={:.2f}% misidentified={:.2f}% rejected={:.2f}%",
+              ratio(r.correct_accept, r.known_visits),
+              ratio(r.misidentified, r.known_visits),
+              ratio(r.false_reject, r.known_visits));
+  SZ_LOG_INFO("stranger: rejected={:.2f}% false_accept={:.2f}%",
+              ratio(r.correct_reject, r.stranger_visits),
+              ratio(r.false_accept, r.stranger_visits));
+  SZ_LOG_INFO("rss kB: start={} enrolled={} end={} (+{}), unknown_db={}",
+              r.rss_start, r.rss_enrolled, r.rss_end,
+              r.rss_end - r.rss_enrolled, r.unknown_db_size);
+}
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+
+  CrowdOptions opt;
+  for (int i = 1; i < argc - 1; i++) {
+    auto arg = std::string(argv[i]);
+    std::string value = argv[i + 1];
+    if (arg == "--identities")
+      opt.identities = std::stoul(value);
+    else if (arg == "--visits")
+      opt.visits = std::stoul(value);
+    else if (arg == "--rate")
+      opt.rate = std::stof(value);
+    else if (arg == "--fps")
+      opt.fps = std::stof(value);
+    else if (arg == "--frames")
+      opt.frames = std::stoi(value);
+    else if (arg == "--noise")
+      opt.noise = std::stof(value);
+    else if (arg == "--stranger-ratio")
+      opt.stranger_ratio = std::stof(value);
+    else if (arg == "--mask-ratio")
+      opt.mask_ratio = std::stof(value);
+    else if (arg == "--db")
+      opt.db_name = value;
+    else if (arg == "--seed")
+      opt.seed = std::stoul(value);
+    else
+      continue;
+    i++;
+  }
+
+  if (opt.identities == 0 || opt.fps <= 0 || opt.frames <= 0) {
+    SZ_LOG_ERROR("Invalid options");
+    return -1;
+  }
+
+  CrowdSimulator simulator(opt);
+  if (!simulator.init()) {
+    SZ_LOG_ERROR("Load config failed");
+    return -1;
+  }
+  simulator.enroll();
+  simulator.run();
+  simulator.report();
+
+  return 0;
+}
+
+#include "crowd-soak-test.moc"
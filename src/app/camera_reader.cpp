@@ -39,6 +39,7 @@ CameraReader::CameraReader(QObject *parent) {
 
   rx_finished_ = true;
   read_cameral_ = true;
+  large_required_ = true;
 }
 
 CameraReader::~CameraReader() {
@@ -63,17 +64,28 @@ void CameraReader::start_sample() { start(); }
 
 void CameraReader::rx_finish() { rx_finished_ = true; }
 
+void CameraReader::set_large_required(bool required) {
+  large_required_ = required;
+}
+
 bool CameraReader::capture_frame(ImagePackage *pkg) {
   auto engine = Engine::instance();
   static int frame_idx = 0;
 
   SZ_RETCODE ret;
 
+  // large channel is only needed by distant faces, far field detection and
+  // hd snapshots
+  bool with_large = !Config::get_app().adaptive_large_capture ||
+                    Config::get_user().upload_hd_snapshot ||
+                    Config::get_detect().far_field_detection ||
+                    large_required_;
+
   {
     ret = engine->capture_frame(io::CAMERA_BGR, 2, *pkg->img_bgr_small);
     if (ret != SZ_RETCODE_OK) return false;
 
-    ret = SZ_RETCODE_FAILED;
+    ret = with_large ? SZ_RETCODE_FAILED : SZ_RETCODE_OK;
     while (ret != SZ_RETCODE_OK) {
       ret = engine->capture_frame(io::CAMERA_BGR, 1, *pkg->img_bgr_large);
       QThread::usleep(10);
@@ -83,7 +95,7 @@ bool CameraReader::capture_frame(ImagePackage *pkg) {
     ret = engine->capture_frame(io::CAMERA_NIR, 2, *pkg->img_nir_small);
     if (ret != SZ_RETCODE_OK) return false;
 
-    ret = SZ_RETCODE_FAILED;
+    ret = with_large ? SZ_RETCODE_FAILED : SZ_RETCODE_OK;
     while (ret != SZ_RETCODE_OK) {
       ret = engine->capture_frame(io::CAMERA_NIR, 1, *pkg->img_nir_large);
       QThread::usleep(10);
@@ -91,6 +103,8 @@ bool CameraReader::capture_frame(ImagePackage *pkg) {
   }
 
   pkg->frame_idx = frame_idx++;
+  pkg->has_large = with_large;
+  pkg->capture_clock = std::chrono::steady_clock::now();
 
   return true;
 }
@@ -4,6 +4,7 @@
 #include <QImage>
 #include <QSharedPointer>
 #include <QThread>
+#include <atomic>
 #include <chrono>
 
 #include <quface-io/engine.hpp>
@@ -24,6 +25,8 @@ class CameraReader : QThread {
 
   bool get_screen_size(int &width, int &height);
 
+  void set_large_required(bool required);
+
  private slots:
   void rx_finish();
   void enable_read_cameral(bool enable);
@@ -43,6 +46,7 @@ class CameraReader : QThread {
   ImagePackage *buffer_ping_, *buffer_pang_;
   PingPangBuffer<ImagePackage> *pingpang_buffer_;
   bool read_cameral_;
+  std::atomic_bool large_required_;
 };
 
 }  // namespace suanzi
@@ -3,8 +3,11 @@
 #include <QRect>
 #include <QThread>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <ctime>
+#include <future>
 #include <iostream>
 #include <string>
 
@@ -13,7 +16,10 @@
 #include <quface/face.hpp>
 
 #include "audio_task.hpp"
+#include "camera_reader.hpp"
 #include "config.hpp"
+#include "image_utils.hpp"
+#include "latency_governor.hpp"
 #include "recognize_task.hpp"
 #include "record_task.hpp"
 #include "temperature_task.hpp"
@@ -26,10 +32,22 @@ DetectTask *DetectTask::get_instance() {
 }
 
 DetectTask::DetectTask(QThread *thread, QObject *parent)
-    : buffer_inited_(false) {
+    : roi_image_(nullptr),
+      frames_since_full_(0),
+      tile_image_(nullptr),
+      perf_counter_("DetectTask detect"),
+      pose_counter_("DetectTask pose"),
+      mode_counter_("DetectTask mode"),
+      nir_worker_(1),
+      last_bgr_detected_(false),
+      config_worker_(1),
+      buffer_inited_(false) {
   auto cfg = Config::get_quface();
   face_detector_ = std::make_shared<FaceDetector>(cfg.model_file_path);
   pose_estimator_ = std::make_shared<FacePoseEstimator>(cfg.model_file_path);
+  nir_face_detector_ = std::make_shared<FaceDetector>(cfg.model_file_path);
+  nir_pose_estimator_ =
+      std::make_shared<FacePoseEstimator>(cfg.model_file_path);
 
   // Create thread
   if (thread == nullptr) {
@@ -45,6 +63,8 @@ DetectTask::DetectTask(QThread *thread, QObject *parent)
 }
 
 DetectTask::~DetectTask() {
+  if (roi_image_) delete roi_image_;
+  if (tile_image_) delete tile_image_;
   if (buffer_ping_) delete buffer_ping_;
   if (buffer_pang_) delete buffer_pang_;
   if (pingpang_buffer_) delete pingpang_buffer_;
@@ -64,13 +84,76 @@ void DetectTask::rx_frame(PingPangBuffer<ImagePackage> *buffer) {
         new PingPangBuffer<DetectionData>(buffer_ping_, buffer_pang_);
   }
 
+  // under load every other frame is dropped
+  skip_frame_ = !skip_frame_ &&
+                LatencyGovernor::degraded(LatencyGovernor::LOWER_DETECTION);
+  if (skip_frame_) {
+    emit tx_finish();
+    return;
+  }
+
+  // large images are only kept for hd snapshots, models use face chips
   DetectionData *output = pingpang_buffer_->get_ping();
-  input->copy_to(*output);
+  input->copy_to(*output, Config::get_user().upload_hd_snapshot);
+
+  auto frame_start = std::chrono::steady_clock::now();
+  auto mode = illumination_.update(input->img_bgr_small);
+
+  // detect nir concurrently, nir is useless for a frame without bgr face
+  // unless liveness of the track recognized last is still pending
+  bool liveness_pending = RecognizeTask::liveness_pending(last_track_id_);
+  bool detect_nir = !cfg.skip_nir_without_bgr || last_bgr_detected_ ||
+                    liveness_pending;
+  if (mode == IlluminationMonitor::BGR_ONLY)
+    detect_nir = liveness_pending;
+  else if (mode == IlluminationMonitor::NIR_PRIMARY)
+    detect_nir = true;
+  else if (LatencyGovernor::degraded(LatencyGovernor::SKIP_NIR))
+    detect_nir = detect_nir && liveness_pending;
+
+  // once calibrated the nir face is predicted from the bgr face, the nir
+  // detector only runs in darkness where bgr detection depends on it
+  auto nir_mapping = Config::get_nir_mapping();
+  bool predict = Config::get_app().predict_nir_face &&
+                 nir_mapping.size() == 6 &&
+                 mode != IlluminationMonitor::NIR_PRIMARY;
+
+  std::promise<bool> nir_detected;
+  std::future<bool> nir_future = nir_detected.get_future();
+  if (detect_nir && !predict) {
+    nir_worker_.enqueue([&]() {
+      nir_detected.set_value(detect_and_select(
+          input->img_nir_small, output->nir_detection_, false));
+    });
+  } else
+    nir_detected.set_value(false);
+
+  // in darkness bgr is only worth detecting once nir sees a face
+  bool nir_joined = false;
+  bool detect_bgr = true;
+  if (mode == IlluminationMonitor::NIR_PRIMARY) {
+    output->nir_face_detected_ = nir_future.get();
+    nir_joined = true;
+    detect_bgr = output->nir_face_detected_;
+  }
 
-  output->bgr_face_detected_ =
-      detect_and_select(input->img_bgr_small, output->bgr_detection_, true);
-  if (output->bgr_face_detected_)
-    output->bgr_face_valid_ = check(output->bgr_detection_, true);
+  if (detect_bgr) {
+    output->bgr_face_detected_ = detect_and_track(
+        input->img_bgr_small, input->has_large ? input->img_bgr_large : nullptr,
+        output);
+  } else {
+    // tracks age as if nothing was detected
+    std::vector<SZ_UINT32> track_ids;
+    tracker_.update({}, track_ids);
+    output->bgr_faces_.clear();
+    output->bgr_track_id_ = 0;
+    output->bgr_face_detected_ = false;
+  }
+  if (output->bgr_face_detected_) {
+    output->bgr_face_valid_ =
+        check(output->bgr_detection_, true, output->bgr_faces_[0].stable);
+    output->bgr_faces_[0].valid = output->bgr_face_valid_;
+  }
 
   emit tx_bgr_display(output->bgr_detection_, !output->bgr_face_detected_,
                       output->bgr_face_valid_, true);
@@ -78,10 +161,87 @@ void DetectTask::rx_frame(PingPangBuffer<ImagePackage> *buffer) {
   if (TemperatureTask::get_instance()->idle())
     emit tx_temperature_target(output->bgr_detection_, output->bgr_face_valid_);
 
-  output->nir_face_detected_ =
-      detect_and_select(input->img_nir_small, output->nir_detection_, false);
+  last_bgr_detected_ = output->bgr_face_detected_;
+
+  // meter exposure on the largest face
+  if (detect_bgr) {
+    const DetectionRatio *face = nullptr;
+    if (output->bgr_face_detected_) face = &output->bgr_faces_[0].detection;
+    exposure_.update(input->img_bgr_small, face);
+  }
+
+  // display and temperature follow the largest face, recognition the
+  // scheduled one
+  int selected = scheduler_.schedule(input->img_bgr_small, output->bgr_faces_);
+  if (selected > 0) {
+    output->bgr_detection_ = output->bgr_faces_[selected].detection;
+    output->bgr_track_id_ = output->bgr_faces_[selected].track_id;
+    output->bgr_face_valid_ = check(output->bgr_detection_, true,
+                                    output->bgr_faces_[selected].stable);
+  }
+  last_track_id_ = output->bgr_face_detected_ ? output->bgr_track_id_ : 0;
+
+  // join nir before its validation, the largest nir face only matches the
+  // largest bgr face
+  if (!nir_joined) output->nir_face_detected_ = nir_future.get();
+  if (detect_nir && predict && output->bgr_face_detected_) {
+    output->nir_face_detected_ =
+        predict_nir(input->img_nir_small, nir_mapping, output->bgr_detection_,
+                    output->nir_detection_);
+
+    // a miss is either a spoof or a stale mapping, the detector tells
+    if (output->nir_face_detected_) {
+      nir_misses_ = 0;
+    } else {
+      bool detected = detect_and_select(input->img_nir_small,
+                                        output->nir_detection_, false);
+      output->nir_face_detected_ =
+          match_nir(input->img_nir_small, nir_mapping, output->bgr_detection_,
+                    detected, output->nir_detection_);
+      if (output->nir_face_detected_ && ++nir_misses_ >= 10) {
+        SZ_LOG_WARN("NIR mapping is stale, recalibrate");
+        nir_misses_ = 0;
+        save_nir_mapping({});
+      }
+    }
+  } else if (selected > 0 && detect_nir) {
+    output->nir_face_detected_ =
+        match_nir(input->img_nir_small, nir_mapping, output->bgr_detection_,
+                  output->nir_face_detected_, output->nir_detection_);
+  }
   if (output->nir_face_detected_)
-    output->nir_face_valid_ = check(output->nir_detection_, false);
+    output->nir_face_valid_ = check(output->nir_detection_, false, true);
+
+  // calibrate on a single face seen clearly by both sensors
+  if (!predict && Config::get_app().predict_nir_face &&
+      mode != IlluminationMonitor::NIR_PRIMARY &&
+      output->bgr_faces_.size() == 1 && nir_detections_.size() == 1 &&
+      output->bgr_face_valid() && output->nir_face_valid_ &&
+      output->nir_face_valid())
+    calibrate_nir(output->bgr_detection_, output->nir_detection_);
+
+  // cut chips of the selected face for recognition, from the large channel
+  // only if the face is too small for some model
+  auto extract_cfg = Config::get_extract();
+  float min_eye_distance = std::max({extract_cfg.min_eye_distance,
+                                     extract_cfg.min_mask_eye_distance,
+                                     Config::get_liveness().min_eye_distance});
+  output->face_context_.valid = false;
+  if (output->bgr_face_valid()) {
+    bool with_nir = output->nir_face_valid();
+    output->face_context_.build(
+        input->img_bgr_small, with_nir ? input->img_nir_small : nullptr,
+        input->has_large ? input->img_bgr_large : nullptr,
+        with_nir && input->has_large ? input->img_nir_large : nullptr,
+        output->bgr_detection_, min_eye_distance);
+  }
+
+  // capture large channel for following frames if the face is distant
+  CameraReader::get_instance()->set_large_required(
+      output->bgr_face_detected_ &&
+      output->bgr_detection_.eye_distance(input->img_bgr_small->width,
+                                          input->img_bgr_small->height) <
+          min_eye_distance);
   emit tx_nir_display(output->nir_detection_, !output->nir_face_detected_,
                       output->nir_face_valid_, false);
 
@@ -94,63 +254,410 @@ void DetectTask::rx_frame(PingPangBuffer<ImagePackage> *buffer) {
     no_detect_count_++;
   }
 
-  if (RecognizeTask::idle() && (valid_dectect || RecordTask::card_readed()))
+  if (RecognizeTask::idle() && (valid_dectect || RecordTask::card_readed())) {
+    if (selected >= 0) scheduler_.served(output->bgr_track_id_);
     emit tx_frame_for_recognize(pingpang_buffer_);
-  else
+  } else {
     QThread::usleep(10);
+  }
+
+  mode_counter_.add(IlluminationMonitor::mode_name(mode),
+                    PerfCounter::elapsed_ms(frame_start));
+  LatencyGovernor::get_instance()->add(
+      "detect", PerfCounter::elapsed_ms(input->capture_clock));
 
   emit tx_detect_result(valid_dectect);  // fire FaceTimer event
   emit tx_finish();
 }
 
-bool DetectTask::detect_and_select(const MmzImage *image,
-                                   DetectionRatio &detection, bool is_bgr) {
-  auto cfg = Config::get_detect();
+void DetectTask::rx_identity(uint track_id, uint face_id) {
+  scheduler_.set_identified(track_id);
+}
 
-  // skip broken image
+static bool is_broken(const MmzImage *image) {
   int width = ((const SVP_IMAGE_S *)image->pImplData)->u32Width;
   int height = ((const SVP_IMAGE_S *)image->pImplData)->u32Height;
+  return width > height;
+}
 
-  if (width > height) return false;
+bool DetectTask::detect(const MmzImage *image,
+                        std::vector<FaceDetection> &detections, bool is_bgr) {
+  auto cfg = Config::get_detect();
 
-  // detect faces: 256x256  7ms
-  static std::vector<suanzi::FaceDetection> detections;
-  suanzi::FacePose pose;
   detections.clear();
 
+  // detect faces: 256x256  7ms
   int min_face_size = cfg.min_face_size;
   if (!is_bgr) min_face_size *= 0.8;
+  auto detector = is_bgr ? face_detector_ : nir_face_detector_;
   SZ_RETCODE ret =
-      face_detector_->detect((const SVP_IMAGE_S *)image->pImplData, detections,
-                             cfg.threshold, min_face_size);
+      detector->detect((const SVP_IMAGE_S *)image->pImplData, detections,
+                       cfg.threshold, min_face_size);
 
   if (ret != SZ_RETCODE_OK) {
     SZ_LOG_ERROR("Detect error ret={}", ret);
     return false;
   }
-  if (detections.size() == 0) return false;
+
+  // largest face first
+  std::sort(detections.begin(), detections.end(),
+            [](const FaceDetection &a, const FaceDetection &b) {
+              return a.bbox.width * a.bbox.height >
+                     b.bbox.width * b.bbox.height;
+            });
+  return true;
+}
+
+bool DetectTask::detect_and_track(const MmzImage *image,
+                                  const MmzImage *large,
+                                  DetectionData *output) {
+  auto cfg = Config::get_detect();
+
+  output->bgr_faces_.clear();
+  output->bgr_track_id_ = 0;
+
+  // skip broken image
+  if (is_broken(image)) return false;
+
+  if (roi_image_ == nullptr)
+    roi_image_ = new MmzImage(image->width, image->height, SZ_IMAGETYPE_NV21);
+
+  static std::vector<suanzi::FaceDetection> detections;
+  auto start = std::chrono::steady_clock::now();
+  int roi_x, roi_y, roi_width, roi_height;
+  if (select_roi(image, roi_x, roi_y, roi_width, roi_height)) {
+    ImageUtils::crop_nv21(image, roi_x, roi_y, roi_width, roi_height,
+                          roi_image_);
+    if (!detect(roi_image_, detections, true)) return false;
+
+    for (auto &detection : detections) {
+      detection.bbox.x += roi_x;
+      detection.bbox.y += roi_y;
+    }
+    frames_since_full_++;
+    perf_counter_.add("roi", PerfCounter::elapsed_ms(start));
+  } else {
+    if (!detect(image, detections, true)) return false;
+
+    frames_since_full_ = 0;
+    perf_counter_.add("full", PerfCounter::elapsed_ms(start));
+  }
+
+  if (detections.size() > cfg.max_tracking_faces)
+    detections.resize(cfg.max_tracking_faces);
+
+  // associate boxes with tracks
+  std::vector<DetectionRatio> boxes(detections.size());
+  for (int i = 0; i < detections.size(); i++) {
+    auto rect = detections[i].bbox;
+    boxes[i].x = rect.x * 1.0 / image->width;
+    boxes[i].y = rect.y * 1.0 / image->height;
+    boxes[i].width = rect.width * 1.0 / image->width;
+    boxes[i].height = rect.height * 1.0 / image->height;
+  }
+
+  // merge faces too far for this channel, it wins where both see a face
+  if (large != nullptr && cfg.far_field_detection) {
+    start = std::chrono::steady_clock::now();
+    detect_far_field(large, image, far_detections_);
+    for (auto &far : far_detections_) {
+      if (boxes.size() >= cfg.max_tracking_faces) break;
+      bool is_duplicated = false;
+      for (auto &box : boxes)
+        is_duplicated |= box.iou(far) > cfg.min_matching_iou;
+      if (!is_duplicated) boxes.push_back(far);
+    }
+    perf_counter_.add("far_field", PerfCounter::elapsed_ms(start));
+  }
+
+  std::vector<SZ_UINT32> track_ids;
+  tracker_.update(boxes, track_ids);
+
+  // keep tracked faces with a reliable pose, still largest first
+  for (int i = 0; i < boxes.size(); i++) {
+    TrackedFace face;
+    face.track_id = track_ids[i];
+    face.stable = tracker_.is_stable(face.track_id);
+
+    // no track is left for a face once max_tracking_faces are all in view
+    FaceTrack *track = tracker_.find(face.track_id);
+    if (track == nullptr) continue;
+
+    start = std::chrono::steady_clock::now();
+    if (face.stable && propagate_pose(track, boxes[i], face.detection)) {
+      pose_counter_.add("propagated", PerfCounter::elapsed_ms(start));
+    } else {
+      // far faces come with the pose estimated on their tile
+      if (i < detections.size()) {
+        track->has_pose =
+            estimate_pose(image, detections[i], face.detection, true);
+      } else {
+        face.detection = boxes[i];
+        track->has_pose = true;
+      }
+      pose_counter_.add("estimated", PerfCounter::elapsed_ms(start));
+      if (!track->has_pose) continue;
+
+      track->pose_detection = face.detection;
+      track->pose_age = 0;
+    }
+
+    face.valid = face.stable && face.detection.is_valid_pose() &&
+                 face.detection.is_valid_position() &&
+                 face.detection.is_valid_size();
+    output->bgr_faces_.push_back(face);
+  }
+
+  if (output->bgr_faces_.size() == 0) return false;
+
+  output->bgr_detection_ = output->bgr_faces_[0].detection;
+  output->bgr_track_id_ = output->bgr_faces_[0].track_id;
+  return true;
+}
+
+void DetectTask::detect_far_field(const MmzImage *image,
+                                  const MmzImage *small,
+                                  std::vector<DetectionRatio> &detections) {
+  auto cfg = Config::get_detect();
+
+  detections.clear();
+
+  // tracks too small for the small channel are followed by tiles
+  std::vector<DetectionRatio> targets;
+  for (auto &track : tracker_.tracks()) {
+    if (track.detection.width * small->width < cfg.min_face_size * 1.5)
+      targets.push_back(track.predict());
+  }
+
+  // a tile as large as the small channel costs as much as its detection
+  int tile_width = std::min(small->width, image->width) & ~15;
+  int tile_height = std::min(small->height, image->height) & ~1;
+  if (tile_image_ == nullptr)
+    tile_image_ = new MmzImage(tile_width, tile_height, SZ_IMAGETYPE_NV21);
+
+  static std::vector<suanzi::FaceDetection> faces;
+  for (int i = 0; i < cfg.far_field_tiles_per_frame; i++) {
+    int x, y;
+    tile_scheduler_.next(image->width, image->height, tile_width, tile_height,
+                         targets, x, y);
+    ImageUtils::crop_nv21(image, x, y, tile_width, tile_height, tile_image_);
+    if (!detect(tile_image_, faces, true)) continue;
+
+    for (auto &face : faces) {
+      DetectionRatio detection;
+      if (!estimate_pose(tile_image_, face, detection, true)) continue;
+
+      // ratio of tile to ratio of image
+      float scale_x = tile_width * 1.0 / image->width;
+      float scale_y = tile_height * 1.0 / image->height;
+      float offset_x = x * 1.0 / image->width;
+      float offset_y = y * 1.0 / image->height;
+      detection.x = offset_x + detection.x * scale_x;
+      detection.y = offset_y + detection.y * scale_y;
+      detection.width *= scale_x;
+      detection.height *= scale_y;
+      for (int k = 0; k < SZ_LANDMARK_NUM; k++) {
+        detection.landmark[k][0] =
+            offset_x + detection.landmark[k][0] * scale_x;
+        detection.landmark[k][1] =
+            offset_y + detection.landmark[k][1] * scale_y;
+      }
+      detections.push_back(detection);
+    }
+  }
+}
+
+bool DetectTask::propagate_pose(FaceTrack *track, const DetectionRatio &box,
+                                DetectionRatio &detection) {
+  auto cfg = Config::get_detect();
+
+  // under load stable tracks keep their pose until they move
+  if (!track->has_pose) return false;
+  if (++track->pose_age >= cfg.pose_refresh_interval &&
+      !LatencyGovernor::degraded(LatencyGovernor::SKIP_POSE))
+    return false;
+
+  // re-estimate once the face moved noticeably since the last estimation
+  const DetectionRatio &last = track->pose_detection;
+  float shift = std::max({std::abs(box.x - last.x) / last.width,
+                          std::abs(box.y - last.y) / last.height,
+                          std::abs(box.width - last.width) / last.width,
+                          std::abs(box.height - last.height) / last.height});
+  if (shift > cfg.max_pose_shift) return false;
+
+  // move landmarks along with the box, keep head pose
+  detection = last;
+  detection.x = box.x;
+  detection.y = box.y;
+  detection.width = box.width;
+  detection.height = box.height;
+  for (int i = 0; i < SZ_LANDMARK_NUM; i++) {
+    detection.landmark[i][0] =
+        box.x + (last.landmark[i][0] - last.x) * box.width / last.width;
+    detection.landmark[i][1] =
+        box.y + (last.landmark[i][1] - last.y) * box.height / last.height;
+  }
+  return true;
+}
+
+bool DetectTask::select_roi(const MmzImage *image, int &x, int &y,
+                            int &width, int &height) {
+  auto cfg = Config::get_detect();
+
+  if (cfg.full_detect_interval <= 1 ||
+      frames_since_full_ + 1 >= cfg.full_detect_interval)
+    return false;
+
+  auto &tracks = tracker_.tracks();
+  if (tracks.size() == 0) return false;
+
+  // union of expanded predicted boxes
+  float x1 = 1, y1 = 1, x2 = 0, y2 = 0;
+  for (auto &track : tracks) {
+    // refresh the full frame once a track is lost
+    if (track.lost_count > 0) return false;
+
+    DetectionRatio box = track.predict();
+    float dx = box.width * cfg.roi_expand_ratio;
+    float dy = box.height * cfg.roi_expand_ratio;
+    x1 = std::min(x1, box.x - dx);
+    y1 = std::min(y1, box.y - dy);
+    x2 = std::max(x2, box.x + box.width + dx);
+    y2 = std::max(y2, box.y + box.height + dy);
+  }
+  x1 = std::max(x1, 0.f);
+  y1 = std::max(y1, 0.f);
+  x2 = std::min(x2, 1.f);
+  y2 = std::min(y2, 1.f);
+  if (x2 <= x1 || y2 <= y1) return false;
+
+  // nv21 needs even offsets, width is aligned for the detector
+  x = (int)(x1 * image->width) & ~1;
+  y = (int)(y1 * image->height) & ~1;
+  width = ((int)(x2 * image->width) - x + 15) & ~15;
+  height = ((int)(y2 * image->height) - y + 1) & ~1;
+  if (width >= image->width) return false;
+  if (x + width > image->width) x = (image->width - width) & ~1;
+  if (y + height > image->height) height = (image->height - y) & ~1;
+
+  // not worth it if the roi covers most of the frame
+  return width * height < image->width * image->height * 0.6;
+}
+
+bool DetectTask::detect_and_select(const MmzImage *image,
+                                   DetectionRatio &detection, bool is_bgr) {
+  // skip broken image
+  if (is_broken(image)) return false;
+
+  auto &detections = nir_detections_;
+  if (!detect(image, detections, is_bgr) || detections.size() == 0)
+    return false;
 
   // select largest face
-  int max_id = 0;
-  float max_area = detections[0].bbox.width * detections[0].bbox.height;
-  for (int i = 1; i < detections.size(); i++) {
-    float area = detections[i].bbox.width * detections[i].bbox.height;
-    if (area > max_area) {
-      max_id = i;
-      max_area = area;
+  return estimate_pose(image, detections[0], detection, is_bgr);
+}
+
+bool DetectTask::match_nir(const MmzImage *image,
+                           const std::vector<SZ_FLOAT> &mapping,
+                           const DetectionRatio &bgr_detection,
+                           bool largest_detected, DetectionRatio &detection) {
+  // compare in nir coordinates once the sensors are calibrated
+  DetectionRatio target;
+  if (!NirMapping::map(mapping, bgr_detection, target)) target = bgr_detection;
+
+  // nir face overlapping the bgr face most
+  int matched = -1;
+  float max_iou = 0;
+  for (int i = 0; i < nir_detections_.size(); i++) {
+    auto rect = nir_detections_[i].bbox;
+    DetectionRatio box;
+    box.x = rect.x * 1.0 / image->width;
+    box.y = rect.y * 1.0 / image->height;
+    box.width = rect.width * 1.0 / image->width;
+    box.height = rect.height * 1.0 / image->height;
+
+    float iou = box.iou(target);
+    if (iou > max_iou) {
+      matched = i;
+      max_iou = iou;
     }
   }
 
+  if (matched < 0) return false;
+  if (matched == 0) return largest_detected;
+  return estimate_pose(image, nir_detections_[matched], detection, false);
+}
+
+bool DetectTask::predict_nir(const MmzImage *image,
+                             const std::vector<SZ_FLOAT> &mapping,
+                             const DetectionRatio &bgr_detection,
+                             DetectionRatio &detection) {
+  if (is_broken(image)) return false;
+
+  DetectionRatio predicted;
+  if (!NirMapping::map(mapping, bgr_detection, predicted)) return false;
+
+  float x1 = std::max(predicted.x, 0.f) * image->width;
+  float y1 = std::max(predicted.y, 0.f) * image->height;
+  float x2 = std::min(predicted.x + predicted.width, 1.f) * image->width;
+  float y2 = std::min(predicted.y + predicted.height, 1.f) * image->height;
+  if (x2 - x1 < 8 || y2 - y1 < 8) return false;
+
+  // landmark estimation on the predicted box verifies there is a face
+  FaceDetection face;
+  face.bbox.x = x1;
+  face.bbox.y = y1;
+  face.bbox.width = x2 - x1;
+  face.bbox.height = y2 - y1;
+  face.score = 1;
+  return estimate_pose(image, face, detection, false);
+}
+
+void DetectTask::calibrate_nir(const DetectionRatio &bgr_detection,
+                               const DetectionRatio &nir_detection) {
+  nir_mapping_.add_sample(bgr_detection, nir_detection);
+  if (nir_mapping_.sample_count() < Config::get_app().nir_calibration_frames)
+    return;
+
+  std::vector<SZ_FLOAT> mapping;
+  if (nir_mapping_.fit(mapping)) {
+    SZ_LOG_INFO(
+        "NIR mapping calibrated: [{:.3f}, {:.3f}, {:.3f}, {:.3f}, {:.3f}, "
+        "{:.3f}]",
+        mapping[0], mapping[1], mapping[2], mapping[3], mapping[4],
+        mapping[5]);
+    save_nir_mapping(mapping);
+  } else {
+    SZ_LOG_WARN("NIR mapping calibration failed, restart");
+  }
+  nir_mapping_.clear();
+}
+
+void DetectTask::save_nir_mapping(const std::vector<SZ_FLOAT> &mapping) {
+  Config::set_nir_mapping(mapping);
+
+  config_worker_.enqueue([]() {
+    json cfg;
+    Config::to_json(cfg);
+    Config::get_instance()->save_diff(cfg);
+  });
+}
+
+bool DetectTask::estimate_pose(const MmzImage *image, FaceDetection &face,
+                               DetectionRatio &detection, bool is_bgr) {
+  suanzi::FacePose pose;
+
+  auto estimator = is_bgr ? pose_estimator_ : nir_pose_estimator_;
   float prob_threshold = is_bgr ? 0.9 : 0.75;
-  ret = pose_estimator_->estimate((const SVP_IMAGE_S *)image->pImplData,
-                                  detections[max_id], pose, prob_threshold);
+  SZ_RETCODE ret = estimator->estimate(
+      (const SVP_IMAGE_S *)image->pImplData, face, pose, prob_threshold);
   if (ret != SZ_RETCODE_OK) {
     // SZ_LOG_ERROR("Pose estimating error. Low quality", ret);
     return false;
   }
 
   // return ratio of bbox
-  auto rect = detections[max_id].bbox;
+  auto rect = face.bbox;
   detection.x = rect.x * 1.0 / image->width;
   detection.y = rect.y * 1.0 / image->height;
   detection.width = rect.width * 1.0 / image->width;
@@ -170,11 +677,11 @@ bool DetectTask::detect_and_select(const MmzImage *image,
   return true;
 }
 
-bool DetectTask::check(DetectionRatio detection, bool is_bgr) {
+bool DetectTask::check(DetectionRatio detection, bool is_bgr, bool is_stable) {
   if (!detection.is_valid_pose()) return false;
 
   if (is_bgr) {
-    if (!is_stable(detection)) return false;
+    if (!is_stable) return false;
 
     static int invalid_count = 0;
     if (!detection.is_valid_position() || !detection.is_valid_size()) {
@@ -192,37 +699,3 @@ bool DetectTask::check(DetectionRatio detection, bool is_bgr) {
 
   return true;
 }
-
-bool DetectTask::is_stable(DetectionRatio detection) {
-  static int stable_counter = 0;
-
-  static float x1 = 0;
-  static float y1 = 0;
-  static float w1 = 0;
-  static float h1 = 0;
-
-  auto cfg = Config::get_detect();
-
-  float x2 = detection.x, y2 = detection.y;
-  float w2 = detection.width, h2 = detection.height;
-
-  if (x1 > x2 + w2 || y1 > y2 + h2 || x1 + w1 < x2 || y1 + h1 < y2)
-    stable_counter = 0;
-  else {
-    float overlay_w = std::min(x1 + w1, x2 + w2) - std::max(x1, x2);
-    float overlay_h = std::min(y1 + h1, y2 + h2) - std::max(y1, y2);
-    float iou = overlay_w * overlay_h / (w1 * h1 + w2 * h2) * 2;
-
-    if (iou >= cfg.min_tracking_iou)
-      stable_counter++;
-    else
-      stable_counter = 0;
-  }
-
-  x1 = x2;
-  y1 = y2;
-  w1 = w2;
-  h1 = h2;
-
-  return stable_counter >= cfg.min_tracking_number;
-}
@@ -7,9 +7,17 @@
 
 #include "config.hpp"
 #include "detection_data.hpp"
+#include "exposure_controller.hpp"
+#include "face_tracker.hpp"
+#include "illumination_monitor.hpp"
 #include "image_package.hpp"
+#include "nir_mapping.hpp"
+#include "perf_counter.hpp"
 #include "pingpang_buffer.hpp"
 #include "quface_common.hpp"
+#include "recognition_scheduler.hpp"
+#include "thread_pool.hpp"
+#include "tile_scheduler.hpp"
 
 namespace suanzi {
 
@@ -20,6 +28,7 @@ class DetectTask : QObject {
 
  private slots:
   void rx_frame(PingPangBuffer<ImagePackage> *buffer);
+  void rx_identity(uint track_id, uint face_id);
 
  signals:
   void tx_finish();
@@ -48,18 +57,79 @@ class DetectTask : QObject {
   DetectTask(QThread *thread = nullptr, QObject *parent = nullptr);
   ~DetectTask();
 
+  bool detect(const MmzImage *image, std::vector<FaceDetection> &detections,
+              bool is_bgr);
+  bool detect_and_track(const MmzImage *image, const MmzImage *large,
+                        DetectionData *output);
+  void detect_far_field(const MmzImage *image, const MmzImage *small,
+                        std::vector<DetectionRatio> &detections);
+  bool propagate_pose(FaceTrack *track, const DetectionRatio &box,
+                      DetectionRatio &detection);
+  bool select_roi(const MmzImage *image, int &x, int &y, int &width,
+                  int &height);
   bool detect_and_select(const MmzImage *image, DetectionRatio &detection,
                          bool is_bgr);
-  bool check(DetectionRatio detection, bool is_bgr);
-  bool is_stable(DetectionRatio detection);
+  bool match_nir(const MmzImage *image, const std::vector<SZ_FLOAT> &mapping,
+                 const DetectionRatio &bgr_detection, bool largest_detected,
+                 DetectionRatio &detection);
+  bool predict_nir(const MmzImage *image, const std::vector<SZ_FLOAT> &mapping,
+                   const DetectionRatio &bgr_detection,
+                   DetectionRatio &detection);
+  void calibrate_nir(const DetectionRatio &bgr_detection,
+                     const DetectionRatio &nir_detection);
+  void save_nir_mapping(const std::vector<SZ_FLOAT> &mapping);
+  bool estimate_pose(const MmzImage *image, FaceDetection &face,
+                     DetectionRatio &detection, bool is_bgr);
+  bool check(DetectionRatio detection, bool is_bgr, bool is_stable);
 
   FaceDetectorPtr face_detector_;
   FacePoseEstimatorPtr pose_estimator_;
+  FaceTracker tracker_;
+
+  // which tracked face is recognized in this frame
+  RecognitionScheduler scheduler_;
+
+  // detect around tracked faces between full frame detections
+  MmzImage *roi_image_;
+  SZ_UINT32 frames_since_full_;
+
+  // faces too far for the small channel are detected on tiles of the large
+  // one, a few tiles per frame
+  TileScheduler tile_scheduler_;
+  MmzImage *tile_image_;
+  std::vector<DetectionRatio> far_detections_;
+  PerfCounter perf_counter_;
+  PerfCounter pose_counter_;
+
+  // modalities by scene brightness, frame latency reported per mode
+  IlluminationMonitor illumination_;
+  PerfCounter mode_counter_;
+
+  // bgr exposure metered on the largest face
+  ExposureController exposure_;
+
+  // nir channel has its own models and runs on its own core
+  FaceDetectorPtr nir_face_detector_;
+  FacePoseEstimatorPtr nir_pose_estimator_;
+  std::vector<FaceDetection> nir_detections_;
+  ThreadPool nir_worker_;
+  bool last_bgr_detected_;
+  SZ_UINT32 last_track_id_ = 0;
+
+  // nir face predicted from the bgr face once the sensors are calibrated,
+  // the detector takes over when predictions keep missing
+  NirMapping nir_mapping_;
+  int nir_misses_ = 0;
+
+  // config file writes stay off the frame path
+  ThreadPool config_worker_;
 
   std::atomic_bool buffer_inited_;
   DetectionData *buffer_ping_, *buffer_pang_;
   PingPangBuffer<DetectionData> *pingpang_buffer_;
 
+  bool skip_frame_ = false;
+
   uint detect_count_ = 0;
   uint no_detect_count_ = 0;
 };
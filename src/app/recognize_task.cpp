@@ -2,12 +2,16 @@
 
 #include <QThread>
 #include <chrono>
+#include <cmath>
 #include <ctime>
+#include <future>
 #include <iostream>
 #include <quface/logger.hpp>
 #include <string>
 
 #include "config.hpp"
+#include "face_quality.hpp"
+#include "latency_governor.hpp"
 #include "record_task.hpp"
 
 using namespace suanzi;
@@ -19,42 +23,53 @@ RecognizeTask *RecognizeTask::get_instance() {
 
 bool RecognizeTask::idle() { return !get_instance()->is_running_; }
 
+bool RecognizeTask::liveness_pending(SZ_UINT32 track_id) {
+  if (!Config::enable_anti_spoofing() || track_id == 0) return false;
+
+  auto task = get_instance();
+  std::unique_lock<std::mutex> lock(task->live_mutex_);
+  return task->live_decided_.count(track_id) == 0;
+}
+
 RecognizeTask::RecognizeTask(QThread *thread, QObject *parent)
-    : is_running_(false) {
+    : is_running_(false),
+      watchlist_counter_("RecognizeTask watchlist"),
+      reentry_counter_("RecognizeTask reentry"),
+      perf_counter_("RecognizeTask extract"),
+      attribute_counter_("RecognizeTask attribute"),
+      liveness_cascade_("RecognizeTask liveness", LIVENESS_STAGES),
+      attribute_worker_(1) {
   auto cfg = Config::get_quface();
   face_database_ = std::make_shared<FaceDatabase>(cfg.db_name);
+  watchlist_database_ = std::make_shared<FaceDatabase>("_WATCHLIST_DB_");
+
+  // recent identities don't outlive the process
+  recent_database_ = std::make_shared<FaceDatabase>("_RECENT_DB_");
+  recent_database_->clear();
 
   face_extractor_ = std::make_shared<FaceExtractor>(cfg.model_file_path);
   anti_spoofing_ = std::make_shared<FaceAntiSpoofing>(cfg.model_file_path);
   mask_detector_ = std::make_shared<MaskDetector>(cfg.model_file_path);
 
-  // Initialize PINGPANG buffer
-  Size size_bgr_1 = VPSS_CH_SIZES_BGR[1];
+  // Initialize PINGPANG buffer, large images are allocated by the first hd
+  // snapshot
+  Size size_large = {0, 0};
   Size size_bgr_2 = VPSS_CH_SIZES_BGR[2];
-  if (CH_ROTATES_BGR[1]) {
-    size_bgr_1.height = VPSS_CH_SIZES_BGR[1].width;
-    size_bgr_1.width = VPSS_CH_SIZES_BGR[1].height;
-  }
   if (CH_ROTATES_BGR[2]) {
     size_bgr_2.height = VPSS_CH_SIZES_BGR[2].width;
     size_bgr_2.width = VPSS_CH_SIZES_BGR[2].height;
   }
 
-  Size size_nir_1 = VPSS_CH_SIZES_NIR[1];
   Size size_nir_2 = VPSS_CH_SIZES_NIR[2];
-  if (CH_ROTATES_NIR[1]) {
-    size_nir_1.height = VPSS_CH_SIZES_NIR[1].width;
-    size_nir_1.width = VPSS_CH_SIZES_NIR[1].height;
-  }
   if (CH_ROTATES_NIR[2]) {
     size_nir_2.height = VPSS_CH_SIZES_NIR[2].width;
     size_nir_2.width = VPSS_CH_SIZES_NIR[2].height;
   }
 
   buffer_ping_ =
-      new RecognizeData(size_bgr_1, size_bgr_2, size_nir_1, size_nir_2);
+      new RecognizeData(size_large, size_bgr_2, size_large, size_nir_2);
   buffer_pang_ =
-      new RecognizeData(size_bgr_1, size_bgr_2, size_nir_1, size_nir_2);
+      new RecognizeData(size_large, size_bgr_2, size_large, size_nir_2);
   pingpang_buffer_ =
       new PingPangBuffer<RecognizeData>(buffer_ping_, buffer_pang_);
 
@@ -87,32 +102,146 @@ void RecognizeTask::rx_frame(PingPangBuffer<DetectionData> *buffer) {
   buffer->switch_buffer();
   DetectionData *input = buffer->get_pang();
   RecognizeData *output = pingpang_buffer_->get_ping();
-  input->copy_to(*output);
+  input->copy_to(*output, Config::get_user().upload_hd_snapshot);
 
   output->bgr_face_detected_ = input->bgr_face_detected_;
   output->nir_face_detected_ = input->nir_face_detected_;
   output->bgr_detection_ = input->bgr_detection_;
   output->nir_detection_ = input->nir_detection_;
+  output->bgr_faces_ = input->bgr_faces_;
+  output->bgr_track_id_ = input->bgr_track_id_;
   output->has_live = !rx_nir_finished_;
   output->has_person_info = !rx_bgr_finished_;
+  output->identity_locked = false;
+  output->watchlist_hit = false;
+  output->fused_count = 1;
 
   if (input->bgr_face_valid()) {
+    TrackRecord &record = update_track(input);
+    auto start = std::chrono::steady_clock::now();
+
+    // decide which models to run, cached results are reused
+    bool run_live = false, run_mask = false, run_extract = false;
     if (output->has_live) {
       if (!Config::enable_anti_spoofing())
         output->is_live = true;
+      else if (reuse_attribute(record.liveness, input, output->is_live))
+        attribute_counter_.add("live_cached", 0);
       else
-        output->is_live = is_live(input);
+        run_live = true;
     }
     if (output->has_person_info) {
-      output->has_mask = has_mask(input);
-      extract_and_query(input, output->has_mask, output->person_feature,
-                        output->person_info);
+      if (reuse_identity(record, input, output)) {
+        perf_counter_.add("cached", PerfCounter::elapsed_ms(start));
+      } else if (is_worth_extracting(record, input)) {
+        run_extract = true;
+        if (reuse_attribute(record.mask, input, output->has_mask))
+          attribute_counter_.add("mask_cached", 0);
+        else
+          run_mask = true;
+      } else {
+        output->has_person_info = false;
+        perf_counter_.add("skipped", PerfCounter::elapsed_ms(start));
+      }
+    }
+
+    // chips of the face are cut by DetectTask, a face without chips is not
+    // checked and gives no vote. Mask is voted along with person info
+    const FaceContext &face = input->face_context_;
+    if ((run_live || run_mask || run_extract) && !face.valid) {
+      if (run_live) output->has_live = false;
+      if (run_mask || run_extract) output->has_person_info = false;
+      run_live = run_mask = run_extract = false;
+    }
+
+    // a face too small for a model, e.g. the first frame of a distant track
+    // before the large channel is captured, gives no result instead of a
+    // bad one. Extraction needs the mask state as well.
+    if (run_live && !face.has_chip(Config::get_liveness().min_eye_distance)) {
+      output->has_live = false;
+      run_live = false;
+    }
+    if (run_extract &&
+        (!face.has_chip(Config::get_extract().min_eye_distance) ||
+         (run_mask &&
+          !face.has_chip(Config::get_extract().min_mask_eye_distance)))) {
+      output->has_person_info = false;
+      run_extract = run_mask = false;
+    }
+
+    // anti-spoofing and mask on the worker, extraction and query here
+    float live_ms = 0, mask_ms = 0;
+    std::promise<void> attributes_done;
+    std::future<void> attributes_future = attributes_done.get_future();
+    if (run_live || run_mask) {
+      attribute_worker_.enqueue([&]() {
+        auto worker_start = std::chrono::steady_clock::now();
+        if (run_live) {
+          output->is_live = is_live(input, face);
+          live_ms = PerfCounter::elapsed_ms(worker_start);
+        }
+        if (run_mask) {
+          worker_start = std::chrono::steady_clock::now();
+          output->has_mask = has_mask(face);
+          mask_ms = PerfCounter::elapsed_ms(worker_start);
+        }
+        attributes_done.set_value();
+      });
+    } else
+      attributes_done.set_value();
+
+    bool extracted = false;
+    if (run_extract) extracted = extract(face, output->person_feature);
+
+    attributes_future.wait();
+
+    if (run_live) attribute_counter_.add("live_evaluated", live_ms);
+    if (run_mask) attribute_counter_.add("mask_evaluated", mask_ms);
+    if (run_extract) {
+      // a returning person is decided on a single frame, the hit counts as
+      // a full history of votes unless RecordTask runs the sequential test,
+      // which weighs it as one measurement. Mask is known only now, features are fused
+      // per mask state. A failed extraction is no vote and leaves the track
+      // record untouched.
+      if (!extracted) {
+        output->has_person_info = false;
+        perf_counter_.add("failed", PerfCounter::elapsed_ms(start));
+      } else if (!record.watchlist_alerted &&
+          query_watchlist(output->person_feature, output->has_mask,
+                          output->person_info)) {
+        record.watchlist_alerted = true;
+        output->watchlist_hit = true;
+        record.fused_count = 0;
+        verify_identity(record, input, output);
+        perf_counter_.add("watchlist", PerfCounter::elapsed_ms(start));
+      } else if (!output->has_mask && !record.identity_locked &&
+                 query_recent(output->person_feature, output->person_info)) {
+        output->fused_count = Config::get_extract().history_size;
+        record.fused_count = 0;
+        verify_identity(record, input, output);
+        perf_counter_.add("recent", PerfCounter::elapsed_ms(start));
+      } else if (!fuse_feature(record, output)) {
+        output->has_person_info = false;
+        perf_counter_.add("fused", PerfCounter::elapsed_ms(start));
+      } else {
+        bool found = query(output->person_feature, output->person_info);
+        if (found && output->has_mask)
+          output->person_info.score =
+              pow((output->person_info.score - 0.5) * 2, 0.45) / 2 + 0.5;
+        verify_identity(record, input, output);
+        perf_counter_.add("extracted", PerfCounter::elapsed_ms(start));
+      }
     }
   } else {
     output->has_live = false;
     output->has_person_info = false;
   }
 
+  publish_liveness();
+
+  LatencyGovernor::get_instance()->add(
+      "recognize", PerfCounter::elapsed_ms(input->capture_clock));
+
   if (RecordTask::idle())
     emit tx_frame(pingpang_buffer_);
   else
@@ -129,45 +258,226 @@ void RecognizeTask::rx_bgr_finish(bool if_finished) {
   rx_bgr_finished_ = if_finished;
 }
 
-bool RecognizeTask::is_live(DetectionData *detection) {
-  if (!detection->nir_face_valid() || !detection->bgr_face_valid())
+void RecognizeTask::rx_identity(uint track_id, uint face_id) {
+  auto it = track_records_.find(track_id);
+  if (it == track_records_.end() || !it->second.has_identity ||
+      it->second.person_info.face_id != face_id)
+    return;
+
+  if (!it->second.identity_locked) {
+    SZ_LOG_INFO("track={} identity locked, id={}", track_id, face_id);
+    if (!it->second.has_mask) remember(face_id, it->second.person_feature);
+  }
+  it->second.identity_locked = true;
+}
+
+void RecognizeTask::rx_liveness(uint track_id, bool is_live) {
+  auto it = track_records_.find(track_id);
+  if (it != track_records_.end())
+    decide_attribute(it->second, it->second.liveness, is_live);
+  publish_liveness();
+}
+
+void RecognizeTask::publish_liveness() {
+  std::unique_lock<std::mutex> lock(live_mutex_);
+  live_decided_.clear();
+  for (auto &it : track_records_) {
+    if (it.second.liveness.decided) live_decided_.insert(it.first);
+  }
+}
+
+void RecognizeTask::rx_mask(uint track_id, bool has_mask) {
+  auto it = track_records_.find(track_id);
+  if (it != track_records_.end())
+    decide_attribute(it->second, it->second.mask, has_mask);
+}
+
+static float box_shift(const DetectionRatio &last,
+                       const DetectionRatio &current) {
+  return std::max(std::abs(current.x - last.x) / last.width,
+                  std::abs(current.y - last.y) / last.height);
+}
+
+RecognizeTask::TrackRecord &RecognizeTask::update_track(
+    DetectionData *detection) {
+  // forget tracks out of view, a re-acquired face gets a new track
+  int max_lost_age = Config::get_extract().max_lost_age;
+  for (auto it = track_records_.begin(); it != track_records_.end();) {
+    if (detection->frame_idx - it->second.last_frame_idx > max_lost_age)
+      it = track_records_.erase(it);
+    else
+      it++;
+  }
+
+  TrackRecord &record = track_records_[detection->bgr_track_id_];
+  record.last_frame_idx = detection->frame_idx;
+  record.last_detection = detection->bgr_detection_;
+  return record;
+}
+
+bool RecognizeTask::reuse_identity(TrackRecord &record,
+                                   DetectionData *detection,
+                                   RecognizeData *output) {
+  if (!record.identity_locked) return false;
+
+  auto cfg = Config::get_extract();
+
+  // verify periodically
+  if (detection->frame_idx - record.verify_frame_idx >=
+      cfg.identity_verify_interval)
+    return false;
+
+  // verify if the track jumped
+  if (box_shift(record.detection, detection->bgr_detection_) >
+      cfg.max_identity_shift)
     return false;
 
-  assert(detection->img_nir_large->width == detection->img_bgr_large->width);
-  assert(detection->img_nir_large->height == detection->img_bgr_large->height);
-  int width = detection->img_nir_large->width;
-  int height = detection->img_nir_large->height;
+  output->has_mask = record.has_mask;
+  output->person_info = record.person_info;
+  memcpy(output->person_feature.value, record.person_feature.value,
+         SZ_FEATURE_NUM * sizeof(SZ_FLOAT));
+  output->identity_locked = true;
+  return true;
+}
+
+void RecognizeTask::verify_identity(TrackRecord &record,
+                                    DetectionData *detection,
+                                    RecognizeData *output) {
+  if (record.identity_locked) {
+    // keep the lock only if the same person is found again
+    auto cfg = Config::get_extract();
+    if (output->person_info.face_id != record.person_info.face_id ||
+        output->person_info.score < cfg.min_recognize_score) {
+      SZ_LOG_INFO("track={} identity lost, id={} --> {}",
+                  detection->bgr_track_id_, record.person_info.face_id,
+                  output->person_info.face_id);
+      record.identity_locked = false;
+    }
+  }
 
-  suanzi::FaceDetection face_detection;
-  suanzi::FacePose pose;
-  detection->bgr_detection_.scale(width, height, face_detection, pose);
+  record.has_identity = true;
+  record.person_info = output->person_info;
+  memcpy(record.person_feature.value, output->person_feature.value,
+         SZ_FEATURE_NUM * sizeof(SZ_FLOAT));
+  record.has_mask = output->has_mask;
+  record.detection = detection->bgr_detection_;
+  record.verify_frame_idx = detection->frame_idx;
+}
 
-  SZ_BOOL is_live;
-  SZ_RETCODE ret = anti_spoofing_->ir_validate(
-      (const SVP_IMAGE_S *)detection->img_nir_large->pImplData, face_detection,
-      is_live, Config::get_user().ir_validate_score);
-  if (SZ_RETCODE_OK != ret || is_live != SZ_TRUE) return false;
+bool RecognizeTask::reuse_attribute(AttributeCache &cache,
+                                    DetectionData *detection, bool &value) {
+  if (!cache.decided) return false;
 
-  ret = anti_spoofing_->rgb_validate(
-      (const SVP_IMAGE_S *)detection->img_bgr_large->pImplData, face_detection,
-      is_live, Config::get_user().bgr_validate_score);
-  if (SZ_RETCODE_OK != ret || is_live != SZ_TRUE) return false;
+  // revalidate after a while or once the face moved
+  auto cfg = Config::get_extract();
+  if (detection->frame_idx - cache.frame_idx >= cfg.attribute_verify_interval ||
+      box_shift(cache.detection, detection->bgr_detection_) >
+          cfg.max_attribute_shift) {
+    cache.decided = false;
+    return false;
+  }
 
+  value = cache.value;
   return true;
 }
 
-bool RecognizeTask::has_mask(DetectionData *detection) {
-  int width = detection->img_bgr_large->width;
-  int height = detection->img_bgr_large->height;
+void RecognizeTask::decide_attribute(const TrackRecord &record,
+                                     AttributeCache &cache, bool value) {
+  // decisions made from cached values must not extend the cache
+  if (cache.decided) return;
+
+  cache.decided = true;
+  cache.value = value;
+  cache.detection = record.last_detection;
+  cache.frame_idx = record.last_frame_idx;
+}
 
-  suanzi::FaceDetection face_detection;
-  suanzi::FacePose pose;
-  detection->bgr_detection_.scale(width, height, face_detection, pose);
+bool RecognizeTask::is_worth_extracting(TrackRecord &record,
+                                        DetectionData *detection) {
+  auto cfg = Config::get_extract();
+  if (cfg.quality_window <= 0 && cfg.fusion_size <= 1) return true;
+
+  int frame_idx = detection->frame_idx;
+  float quality = FaceQuality::evaluate(detection->img_bgr_small,
+                                        detection->bgr_detection_);
+  record.quality = quality;
+  if (cfg.quality_window <= 0) return true;
+
+  // extract on the first frame of a track, on a better frame than the best
+  // one within the window, or once the window expired. Locked identities
+  // reaching here are due for verification.
+  if (!record.has_quality ||
+      frame_idx - record.best_frame_idx >= cfg.quality_window ||
+      quality > record.best_quality + cfg.min_quality_gain ||
+      record.identity_locked) {
+    record.has_quality = true;
+    record.best_quality = quality;
+    record.best_frame_idx = frame_idx;
+    return true;
+  }
+
+  return false;
+}
+
+bool RecognizeTask::is_live(DetectionData *detection,
+                            const FaceContext &face) {
+  const FaceChip &chip = face.chip(Config::get_liveness().min_eye_distance);
+  if (!detection->nir_face_valid() || !detection->bgr_face_valid() ||
+      !chip.has_nir)
+    return false;
+
+  // screens and prints are rejected before any model runs
+  if (!is_nir_plausible(chip)) return false;
+
+  for (int stage : liveness_cascade_.order()) {
+    auto start = std::chrono::steady_clock::now();
+
+    SZ_BOOL is_live;
+    SZ_RETCODE ret;
+    if (stage == IR_VALIDATE)
+      ret = anti_spoofing_->ir_validate(chip.nir_image(), chip.detection,
+                                        is_live,
+                                        Config::get_user().ir_validate_score);
+    else
+      ret = anti_spoofing_->rgb_validate(chip.bgr_image(), chip.detection,
+                                         is_live,
+                                         Config::get_user().bgr_validate_score);
+
+    bool rejected = SZ_RETCODE_OK != ret || is_live != SZ_TRUE;
+    liveness_cascade_.update(stage, PerfCounter::elapsed_ms(start), rejected);
+    if (rejected) return false;
+  }
+
+  return true;
+}
+
+bool RecognizeTask::is_nir_plausible(const FaceChip &chip) {
+  auto cfg = Config::get_liveness();
+  if (!cfg.nir_precheck) return true;
+
+  // a screen emits no nir light and a print lacks the relief of a face, both
+  // show as a dark or flat face region
+  auto &bbox = chip.detection.bbox;
+  float mean, stddev;
+  if (!FaceQuality::luma_statistics(chip.nir_chip.get(), bbox.x, bbox.y,
+                                    bbox.width, bbox.height, mean, stddev))
+    return true;
+
+  if (mean < cfg.min_nir_brightness || stddev < cfg.min_nir_contrast) {
+    SZ_LOG_DEBUG("nir precheck rejected, mean={:.1f}, stddev={:.1f}", mean,
+                 stddev);
+    return false;
+  }
+  return true;
+}
+
+bool RecognizeTask::has_mask(const FaceContext &face) {
+  const FaceChip &chip = face.chip(Config::get_extract().min_mask_eye_distance);
 
   SZ_BOOL has_mask;
-  SZ_RETCODE ret = mask_detector_->classify(
-      (const SVP_IMAGE_S *)detection->img_bgr_large->pImplData, face_detection,
-      has_mask, Config::get_user().mask_score);
+  SZ_RETCODE ret =
+      mask_detector_->classify(chip.bgr_image(), chip.detection, has_mask,
+                               Config::get_user().mask_score);
 
   if (SZ_RETCODE_OK == ret && has_mask == SZ_TRUE)
     return true;
@@ -175,41 +485,165 @@ bool RecognizeTask::has_mask(DetectionData *detection) {
     return false;
 }
 
-void RecognizeTask::extract_and_query(DetectionData *detection, bool has_mask,
-                                      FaceFeature &feature,
-                                      QueryResult &person_info) {
-  int width = detection->img_bgr_large->width;
-  int height = detection->img_bgr_large->height;
+bool RecognizeTask::fuse_feature(TrackRecord &record,
+                                 RecognizeData *output) {
+  auto cfg = Config::get_extract();
 
-  suanzi::FaceDetection face_detection;
-  suanzi::FacePose pose;
-  detection->bgr_detection_.scale(width, height, face_detection, pose);
+  // verification of a locked identity is a single query
+  if (cfg.fusion_size <= 1 || record.identity_locked) {
+    record.fused_count = 0;
+    return true;
+  }
+
+  // features with and without mask are not mixed
+  if (record.fused_count > 0 && record.fused_mask != output->has_mask)
+    record.fused_count = 0;
+  if (record.fused_count == 0) {
+    memset(record.fused_feature.value, 0, SZ_FEATURE_NUM * sizeof(SZ_FLOAT));
+    record.fused_weight = 0;
+    record.fused_mask = output->has_mask;
+  }
+
+  SZ_FLOAT *value = output->person_feature.value;
+  float norm = 0;
+  for (int i = 0; i < SZ_FEATURE_NUM; i++) norm += value[i] * value[i];
+  norm = std::sqrt(norm);
+  if (norm <= 0) return false;
+
+  float weight = std::max(record.quality, 0.05f);
+  for (int i = 0; i < SZ_FEATURE_NUM; i++)
+    record.fused_feature.value[i] += weight * value[i] / norm;
+  record.fused_weight += weight;
+  if (++record.fused_count < cfg.fusion_size) return false;
+
+  // query once on the normalized template
+  norm = 0;
+  for (int i = 0; i < SZ_FEATURE_NUM; i++)
+    norm += record.fused_feature.value[i] * record.fused_feature.value[i];
+  norm = std::sqrt(norm);
+  for (int i = 0; i < SZ_FEATURE_NUM; i++)
+    value[i] = record.fused_feature.value[i] / norm;
+
+  SZ_LOG_DEBUG("track={} fused {} frames, weight={:.2f}",
+               output->bgr_track_id_, record.fused_count, record.fused_weight);
+  output->fused_count = record.fused_count;
+  record.fused_count = 0;
+  return true;
+}
+
+bool RecognizeTask::extract(const FaceContext &face, FaceFeature &feature) {
+  const FaceChip &chip = face.chip(Config::get_extract().min_eye_distance);
 
   // extract: 25ms
-  SZ_RETCODE ret = face_extractor_->extract(
-      (const SVP_IMAGE_S *)detection->img_bgr_large->pImplData, face_detection,
-      pose, feature);
+  SZ_RETCODE ret = face_extractor_->extract(chip.bgr_image(), chip.detection,
+                                            chip.pose, feature);
+  return SZ_RETCODE_OK == ret;
+}
 
-  if (SZ_RETCODE_OK == ret) {
-    // query
-    static std::vector<suanzi::QueryResult> results;
-    results.clear();
+bool RecognizeTask::query(const FaceFeature &feature,
+                          QueryResult &person_info) {
+  static std::vector<suanzi::QueryResult> results;
+  results.clear();
 
+  // terminals with access groups only search people of those groups
+  SZ_RETCODE ret;
+  if (group_gallery_.enabled()) {
+    ret = group_gallery_.query(feature, person_info);
+    if (SZ_RETCODE_OK == ret) return true;
+  } else {
     ret = face_database_->query(feature, 1, results);
     if (SZ_RETCODE_OK == ret) {
-      if (has_mask)
-        person_info.score = pow((results[0].score - 0.5) * 2, 0.45) / 2 + 0.5;
-      else
-        person_info.score = results[0].score;
+      person_info.score = results[0].score;
       person_info.face_id = results[0].face_id;
-      // SZ_LOG_INFO("mask={}, id={}, score={:.2f}", has_mask,
-      // person_info.face_id,
-      //             person_info.score);
-      return;
+      return true;
     }
   }
 
   // SZ_RETCODE_EMPTY_DATABASE or SZ_RETCODE_FAILED
   person_info.score = 0;
   person_info.face_id = 0;
+  return false;
+}
+
+bool RecognizeTask::query_watchlist(const FaceFeature &feature, bool has_mask,
+                                    QueryResult &person_info) {
+  auto start = std::chrono::steady_clock::now();
+  static std::vector<suanzi::QueryResult> results;
+  results.clear();
+
+  // SZ_RETCODE_EMPTY_DATABASE unless someone is blacklisted
+  SZ_RETCODE ret = watchlist_database_->query(feature, 1, results);
+  if (SZ_RETCODE_OK != ret) return false;
+
+  float score = results[0].score;
+  if (has_mask) score = pow((score - 0.5) * 2, 0.45) / 2 + 0.5;
+  if (score < Config::get_extract().min_watchlist_score) {
+    watchlist_counter_.add("miss", PerfCounter::elapsed_ms(start));
+    return false;
+  }
+
+  SZ_LOG_INFO("watchlist hit, id={}, score={:.2f}", results[0].face_id, score);
+  person_info.score = score;
+  person_info.face_id = results[0].face_id;
+  watchlist_counter_.add("hit", PerfCounter::elapsed_ms(start));
+  return true;
+}
+
+bool RecognizeTask::query_recent(const FaceFeature &feature,
+                                 QueryResult &person_info) {
+  auto cfg = Config::get_extract();
+  if (cfg.reentry_cache_size <= 0) return false;
+
+  expire_recent();
+  if (recent_clocks_.size() == 0) return false;
+
+  auto start = std::chrono::steady_clock::now();
+  static std::vector<suanzi::QueryResult> results;
+  results.clear();
+
+  SZ_RETCODE ret = recent_database_->query(feature, 1, results);
+  if (SZ_RETCODE_OK != ret || results[0].score < cfg.min_reentry_score) {
+    reentry_counter_.add("miss", PerfCounter::elapsed_ms(start));
+    return false;
+  }
+
+  person_info.score = results[0].score;
+  person_info.face_id = results[0].face_id;
+  recent_clocks_[person_info.face_id] = std::chrono::steady_clock::now();
+  reentry_counter_.add("hit", PerfCounter::elapsed_ms(start));
+  return true;
+}
+
+void RecognizeTask::remember(SZ_UINT32 face_id, const FaceFeature &feature) {
+  auto cfg = Config::get_extract();
+  if (cfg.reentry_cache_size <= 0) return;
+
+  expire_recent();
+
+  // make room by dropping the person seen least recently
+  if (recent_clocks_.find(face_id) == recent_clocks_.end() &&
+      recent_clocks_.size() >= cfg.reentry_cache_size) {
+    auto oldest = recent_clocks_.begin();
+    for (auto it = recent_clocks_.begin(); it != recent_clocks_.end(); it++) {
+      if (it->second < oldest->second) oldest = it;
+    }
+    recent_database_->remove(oldest->first);
+    recent_clocks_.erase(oldest);
+  }
+
+  recent_database_->add(face_id, feature);
+  recent_clocks_[face_id] = std::chrono::steady_clock::now();
+}
+
+void RecognizeTask::expire_recent() {
+  auto now = std::chrono::steady_clock::now();
+  int ttl = Config::get_extract().reentry_ttl;
+  for (auto it = recent_clocks_.begin(); it != recent_clocks_.end();) {
+    if (std::chrono::duration_cast<std::chrono::seconds>(now - it->second)
+            .count() > ttl) {
+      recent_database_->remove(it->first);
+      it = recent_clocks_.erase(it);
+    } else
+      it++;
+  }
 }
@@ -2,12 +2,21 @@
 #define RECOGNIZE_TASK_H
 
 #include <QObject>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
 
+#include "adaptive_cascade.hpp"
 #include "config.hpp"
 #include "detection_data.hpp"
+#include "face_context.hpp"
+#include "group_gallery.hpp"
+#include "perf_counter.hpp"
 #include "pingpang_buffer.hpp"
 #include "quface_common.hpp"
 #include "recognize_data.hpp"
+#include "thread_pool.hpp"
 
 namespace suanzi {
 class RecognizeTask : QObject {
@@ -15,11 +24,16 @@ class RecognizeTask : QObject {
  public:
   static RecognizeTask *get_instance();
   static bool idle();
+  // liveness of the track is not decided yet, no track has none pending
+  static bool liveness_pending(SZ_UINT32 track_id);
 
  private slots:
   void rx_frame(PingPangBuffer<DetectionData> *buffer);
   void rx_nir_finish(bool if_finished);
   void rx_bgr_finish(bool if_finished);
+  void rx_identity(uint track_id, uint face_id);
+  void rx_liveness(uint track_id, bool is_live);
+  void rx_mask(uint track_id, bool has_mask);
 
  signals:
   // for output
@@ -29,10 +43,66 @@ class RecognizeTask : QObject {
   RecognizeTask(QThread *thread = nullptr, QObject *parent = nullptr);
   ~RecognizeTask();
 
-  bool is_live(DetectionData *detection);
-  bool has_mask(DetectionData *detection);
-  void extract_and_query(DetectionData *detection, bool has_mask,
-                         FaceFeature &feature, QueryResult &person_info);
+  // per track state: best face quality within the quality window, the
+  // identity confirmed by RecordTask and the decided attributes
+  typedef struct {
+    bool decided;
+    bool value;
+    DetectionRatio detection;
+    int frame_idx;
+  } AttributeCache;
+
+  typedef struct {
+    int last_frame_idx;
+    DetectionRatio last_detection;
+
+    bool has_quality;
+    float quality;
+    float best_quality;
+    int best_frame_idx;
+
+    // quality weighted sum of normalized features of this track
+    FaceFeature fused_feature;
+    float fused_weight;
+    int fused_count;
+    bool fused_mask;
+
+    bool has_identity;
+    bool identity_locked;
+    QueryResult person_info;
+    FaceFeature person_feature;
+    bool has_mask;
+    DetectionRatio detection;
+    int verify_frame_idx;
+
+    AttributeCache liveness;
+    AttributeCache mask;
+
+    bool watchlist_alerted;
+  } TrackRecord;
+
+  TrackRecord &update_track(DetectionData *detection);
+  bool reuse_identity(TrackRecord &record, DetectionData *detection,
+                      RecognizeData *output);
+  void verify_identity(TrackRecord &record, DetectionData *detection,
+                       RecognizeData *output);
+  bool reuse_attribute(AttributeCache &cache, DetectionData *detection,
+                       bool &value);
+  void decide_attribute(const TrackRecord &record, AttributeCache &cache,
+                        bool value);
+  bool is_worth_extracting(TrackRecord &record, DetectionData *detection);
+  bool is_live(DetectionData *detection, const FaceContext &face);
+  bool is_nir_plausible(const FaceChip &chip);
+  bool has_mask(const FaceContext &face);
+  bool fuse_feature(TrackRecord &record, RecognizeData *output);
+  bool extract(const FaceContext &face, FaceFeature &feature);
+  bool query(const FaceFeature &feature, QueryResult &person_info);
+  bool query_watchlist(const FaceFeature &feature, bool has_mask,
+                       QueryResult &person_info);
+  bool query_recent(const FaceFeature &feature, QueryResult &person_info);
+  void remember(SZ_UINT32 face_id, const FaceFeature &feature);
+  void expire_recent();
+  void publish_liveness();
 
   // nyy
   const Size VPSS_CH_SIZES_BGR[3] = {
@@ -50,10 +120,43 @@ class RecognizeTask : QObject {
   bool rx_bgr_finished_;
 
   FaceDatabasePtr face_database_;
+  GroupGallery group_gallery_;
+
+  // blacklisted people only, searched first so that a close whitelisted
+  // face in the gallery can't mask them. Filled by FaceService.
+  FaceDatabasePtr watchlist_database_;
+  PerfCounter watchlist_counter_;
   FaceExtractorPtr face_extractor_;
   FaceAntiSpoofingPtr anti_spoofing_;
   MaskDetectorPtr mask_detector_;
 
+  std::map<SZ_UINT32, TrackRecord> track_records_;
+
+  // tracks with a decided liveness, read by DetectTask
+  std::mutex live_mutex_;
+  std::set<SZ_UINT32> live_decided_;
+
+  // templates of people decided within reentry_ttl seconds, queried before
+  // the gallery with a stricter threshold
+  FaceDatabasePtr recent_database_;
+  std::map<SZ_UINT32, std::chrono::steady_clock::time_point> recent_clocks_;
+  PerfCounter reentry_counter_;
+
+  PerfCounter perf_counter_;
+  PerfCounter attribute_counter_;
+
+  // nir and bgr anti-spoofing, ordered by cost per rejection. Used by
+  // attribute_worker_ only.
+  typedef enum {
+    IR_VALIDATE,
+    RGB_VALIDATE,
+    LIVENESS_STAGES,
+  } LivenessStage;
+  AdaptiveCascade liveness_cascade_;
+
+  // anti-spoofing and mask run here concurrently with extraction
+  ThreadPool attribute_worker_;
+
   RecognizeData *buffer_ping_, *buffer_pang_;
   PingPangBuffer<RecognizeData> *pingpang_buffer_;
 };
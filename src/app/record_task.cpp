@@ -9,6 +9,8 @@
 
 #include "audio_task.hpp"
 #include "config.hpp"
+#include "face_quality.hpp"
+#include "latency_governor.hpp"
 
 #define CONTAIN_KEY(dict, key) ((dict).find((key)) != (dict).end())
 #define SECONDS_DIFF(t1, t2) \
@@ -36,16 +38,20 @@ void RecordTask::clear_temperature() {
 
 RecordTask::RecordTask(QThread *thread, QObject *parent)
     : is_running_(false),
+      track_id_(0),
+      track_frame_idx_(0),
+      watchlist_pending_(false),
       duplicated_counter_(0),
-      latest_temperature_(0),
       has_unhandle_person_(false),
+      latest_temperature_(0),
       has_card_no_(false),
       is_enabled_(true) {
   person_service_ = PersonService::get_instance();
   face_database_ = std::make_shared<FaceDatabase>(Config::get_quface().db_name);
 
   // Create db for unknown faces
-  unknown_database_ = std::make_shared<FaceDatabase>("_UNKNOWN_DB_");
+  unknown_database_ =
+      std::make_shared<FaceDatabase>(Config::get_quface().unknown_db_name);
 
   // Create thread
   if (thread == nullptr) {
@@ -80,20 +86,39 @@ void RecordTask::rx_frame(PingPangBuffer<RecognizeData> *buffer) {
   bool has_mask;
   bool update_record = false;
 
-  if (input->has_person_info) {
-    // reset if new person appear
-    if (if_fresh(input->person_feature)) {
-      rx_reset();
-
+  // reset if new person appear
+  if (input->has_person_info || input->has_live) {
+    if (switch_track(input->bgr_track_id_, input->frame_idx))
       update_record = true;
-    }
+    if (input->bgr_face_valid() &&
+        !LatencyGovernor::degraded(LatencyGovernor::DEFER_SNAPSHOT))
+      update_best_shot(input);
+  }
 
-    // add person info
-    mask_history_.push_back(input->has_mask);
-    person_history_.push_back(input->person_info);
+  // watchlist hits skip the voting, not liveness
+  if (input->has_person_info && input->watchlist_hit) {
+    watchlist_pending_ = true;
+    watchlist_person_ = input->person_info;
+  }
+
+  if (input->has_person_info) {
+    // add person info, a fused query votes once per fused frame. The
+    // sequential test takes it as a single measurement, repeating it would
+    // count the same evidence several times
+    int votes = Config::get_extract().sequential_test ? 1 : input->fused_count;
+    for (int i = 0; i < votes; i++) {
+      mask_history_.push_back(input->has_mask);
+      person_history_.push_back(input->person_info);
+    }
 
     // do sequence mask detection
     bgr_finished = sequence_mask(mask_history_, has_mask);
+    if (bgr_finished) emit tx_mask(input->bgr_track_id_, has_mask);
+
+    // wait for more frames if the identity is not yet decided
+    if (bgr_finished &&
+        query_pending(person_history_, mask_history_, has_mask))
+      bgr_finished = false;
   }
 
   bool is_live = false;
@@ -103,6 +128,7 @@ void RecordTask::rx_frame(PingPangBuffer<RecognizeData> *buffer) {
 
     // do sequence antispoofing
     ir_finished = sequence_antispoof(live_history_, is_live);
+    if (ir_finished) emit tx_liveness(input->bgr_track_id_, is_live);
   }
 
   if (has_card_no_) {
@@ -116,16 +142,23 @@ void RecordTask::rx_frame(PingPangBuffer<RecognizeData> *buffer) {
 
     has_card_no_ = false;
 
+  } else if (is_enabled_ && watchlist_pending_ && ir_finished) {
+    if (is_live) alert_watchlist(input);
+    reset_recognize();
   } else if (is_enabled_ && bgr_finished && ir_finished) {
     if (is_live) {
       SZ_UINT32 face_id;
       PersonData person;
       if (sequence_query(person_history_, mask_history_, has_mask, face_id,
                          person.score)) {
-        if (has_mask && person.score < 0.85)
-          face_database_->add(face_id, input->person_feature, 0.1);
-        if (!has_mask && person.score < 0.9)
+        // feature of a locked identity was already added, group
+        // sub-indexes are searched instead of the gallery if configured
+        if (!input->identity_locked &&
+            person.score < (has_mask ? 0.85 : 0.9)) {
           face_database_->add(face_id, input->person_feature, 0.1);
+          group_gallery_.add(face_id, input->person_feature, 0.1);
+        }
+        emit tx_identity(input->bgr_track_id_, face_id);
       }
       person.has_mask = has_mask;
 
@@ -135,7 +168,7 @@ void RecordTask::rx_frame(PingPangBuffer<RecognizeData> *buffer) {
       if (duplicated_counter_ < cfg.duplication_limit) {
         int duration;
         bool duplicated =
-            if_duplicated(face_id, latest_feature_, duration, person);
+            if_duplicated(face_id, input->person_feature, duration, person);
 
         if (Config::has_temperature_device()) {
           if (!duplicated) latest_temperature_ = 0;
@@ -160,56 +193,70 @@ void RecordTask::rx_frame(PingPangBuffer<RecognizeData> *buffer) {
     reset_recognize();
   }
 
+  LatencyGovernor::get_instance()->add(
+      "record", PerfCounter::elapsed_ms(input->capture_clock), true);
+
   is_running_ = false;
 }
 
-bool RecordTask::if_fresh(const FaceFeature &feature) {
-  float score = 0.0;
-
-#if __ARM_NEON
-  assert(SZ_FEATURE_NUM % 16 == 0);
-  int dim = SZ_FEATURE_NUM;
-
-  const float *com_feat = feature.value;
-  const float *q_feat = latest_feature_.value;
-  float32x4_t out = vmovq_n_f32(0.0);
-  float32x4_t f1, f2;
-  float outTmp[4];
-  for (int k = 0; k < dim; k += 16) {
-    f1 = vld1q_f32(com_feat + k);
-    f2 = vld1q_f32(q_feat + k);
-    out = vmlaq_f32(out, f1, f2);
-
-    f1 = vld1q_f32(com_feat + k + 4);
-    f2 = vld1q_f32(q_feat + k + 4);
-    out = vmlaq_f32(out, f1, f2);
-
-    f1 = vld1q_f32(com_feat + k + 8);
-    f2 = vld1q_f32(q_feat + k + 8);
-    out = vmlaq_f32(out, f1, f2);
-
-    f1 = vld1q_f32(com_feat + k + 12);
-    f2 = vld1q_f32(q_feat + k + 12);
-    out = vmlaq_f32(out, f1, f2);
+bool RecordTask::switch_track(SZ_UINT32 track_id, int frame_idx) {
+  // drop tracks that have left the view
+  int max_lost_age = Config::get_extract().max_lost_age;
+  for (auto it = track_histories_.begin(); it != track_histories_.end();) {
+    if (frame_idx - it->second.frame_idx > max_lost_age)
+      it = track_histories_.erase(it);
+    else
+      it++;
   }
-  vst1q_f32(outTmp, out);
-
-  score = outTmp[0] + outTmp[1] + outTmp[2] + outTmp[3];
-#else
-  for (int k = 0; k < SZ_FEATURE_NUM; k++)
-    score += feature.value[k] * latest_feature_.value[k];
-#endif
 
-  memcpy(latest_feature_.value, feature.value,
-         SZ_FEATURE_NUM * sizeof(SZ_FLOAT));
+  bool is_same = track_id == track_id_ &&
+                 frame_idx - track_frame_idx_ <= max_lost_age;
+  int last_frame_idx = track_frame_idx_;
+  track_frame_idx_ = frame_idx;
+  if (is_same) return false;
+
+  // keep state of current track
+  if (track_id_ != 0 && track_id != track_id_) {
+    track_histories_[track_id_] = {
+        .person_history = person_history_,
+        .mask_history = mask_history_,
+        .live_history = live_history_,
+        .best_shot = best_shot_,
+        .watchlist_pending = watchlist_pending_,
+        .watchlist_person = watchlist_person_,
+        .duplicated_counter = duplicated_counter_,
+        .frame_idx = last_frame_idx,
+    };
+  }
+  track_id_ = track_id;
+
+  auto it = track_histories_.find(track_id);
+  if (it != track_histories_.end()) {
+    person_history_.swap(it->second.person_history);
+    mask_history_.swap(it->second.mask_history);
+    live_history_.swap(it->second.live_history);
+    std::swap(best_shot_, it->second.best_shot);
+    watchlist_pending_ = it->second.watchlist_pending;
+    watchlist_person_ = it->second.watchlist_person;
+    duplicated_counter_ = it->second.duplicated_counter;
+    track_histories_.erase(it);
+    return false;
+  }
 
-  return score / 2 + 0.5f < 0.7;
+  reset_person();
+  return true;
 }
 
 void RecordTask::reset_recognize() {
   mask_history_.clear();
   person_history_.clear();
   live_history_.clear();
+  watchlist_pending_ = false;
+
+  // visit ends with a decision, drop buffers still shared with histories
+  best_shot_.valid = false;
+  best_shot_.bgr.release();
+  best_shot_.nir.release();
 
   emit tx_nir_finish(false);
   emit tx_bgr_finish(false);
@@ -224,6 +271,10 @@ bool RecordTask::sequence_query(const std::vector<QueryResult> &person_history,
                                 const std::vector<bool> &mask_history,
                                 const bool has_mask, SZ_UINT32 &face_id,
                                 SZ_FLOAT &score) {
+  if (Config::get_extract().sequential_test)
+    return sequential_query(person_history, mask_history, has_mask, face_id,
+                            score) == SequentialTest::ACCEPT;
+
   // initialize map
   std::map<SZ_UINT32, int> person_counts;
   std::map<SZ_UINT32, float> person_accumulate_score;
@@ -276,8 +327,87 @@ bool RecordTask::sequence_query(const std::vector<QueryResult> &person_history,
   return false;
 }
 
+bool RecordTask::query_pending(const std::vector<QueryResult> &person_history,
+                               const std::vector<bool> &mask_history,
+                               const bool has_mask) {
+  if (!Config::get_extract().sequential_test) return false;
+
+  SZ_UINT32 face_id;
+  SZ_FLOAT score;
+  return sequential_query(person_history, mask_history, has_mask, face_id,
+                          score) == SequentialTest::UNDECIDED;
+}
+
+SequentialTest::Decision RecordTask::sequential_query(
+    const std::vector<QueryResult> &person_history,
+    const std::vector<bool> &mask_history, const bool has_mask,
+    SZ_UINT32 &face_id, SZ_FLOAT &score) {
+  auto cfg = Config::get_extract();
+
+  // evidence of each recent frame: its score against the threshold
+  std::vector<std::pair<SZ_UINT32, float>> evidences;
+  std::map<SZ_UINT32, float> person_max_score;
+  auto pit = person_history.rbegin();
+  auto mit = mask_history.rbegin();
+  while (pit != person_history.rend() && mit != mask_history.rend() &&
+         evidences.size() < cfg.max_test_length) {
+    if (*mit == has_mask) {
+      evidences.emplace_back(
+          pit->face_id,
+          cfg.score_llr_slope * (pit->score - cfg.min_recognize_score));
+      person_max_score[pit->face_id] =
+          std::max(pit->score, person_max_score[pit->face_id]);
+    }
+    pit++;
+    mit++;
+  }
+  if (evidences.empty()) return SequentialTest::UNDECIDED;
+
+  // a good match to someone else is evidence against a candidate
+  float best_llr = 0;
+  face_id = 0;
+  for (auto &candidate : person_max_score) {
+    float llr = 0;
+    for (auto &evidence : evidences) {
+      if (evidence.first == candidate.first)
+        llr += evidence.second;
+      else
+        llr -= std::max(evidence.second, 0.f);
+    }
+    if (face_id == 0 || llr > best_llr) {
+      best_llr = llr;
+      face_id = candidate.first;
+    }
+  }
+
+  SequentialTest test(cfg.false_accept_rate, cfg.false_reject_rate,
+                      cfg.max_test_length);
+  auto decision = test.decide(best_llr, evidences.size());
+  SZ_LOG_DEBUG("frames={}, id={}, llr={:.2f}, decision={}", evidences.size(),
+               face_id, best_llr, (int)decision);
+
+  score = decision == SequentialTest::ACCEPT ? person_max_score[face_id] : -1;
+  return decision;
+}
+
 bool RecordTask::sequence_antispoof(const std::vector<bool> &history,
                                     bool &is_live) {
+  auto cfg = Config::get_liveness();
+  if (cfg.sequential_test) {
+    float llr = 0;
+    int length = 0;
+    for (auto it = history.rbegin();
+         it != history.rend() && length < cfg.max_test_length; it++, length++)
+      llr += SequentialTest::binary_llr(*it, cfg.live_accuracy);
+
+    SequentialTest test(cfg.false_accept_rate, cfg.false_reject_rate,
+                        cfg.max_test_length);
+    auto decision = test.decide(llr, length);
+    if (decision == SequentialTest::UNDECIDED) return false;
+    is_live = decision == SequentialTest::ACCEPT;
+    return true;
+  }
+
   int min_count = Config::get_liveness().min_alive_count;
   int max_count = Config::get_liveness().history_size;
   if (history.size() < min_count) return false;
@@ -301,6 +431,23 @@ bool RecordTask::sequence_antispoof(const std::vector<bool> &history,
 
 bool RecordTask::sequence_mask(const std::vector<bool> &history,
                                bool &has_mask) {
+  auto cfg = Config::get_extract();
+  if (cfg.sequential_test) {
+    // mask and no mask are decided with the same error rate
+    float llr = 0;
+    int length = 0;
+    for (auto it = history.rbegin();
+         it != history.rend() && length < cfg.max_test_length; it++, length++)
+      llr += SequentialTest::binary_llr(*it, cfg.mask_accuracy);
+
+    SequentialTest test(cfg.false_reject_rate, cfg.false_reject_rate,
+                        cfg.max_test_length, true);
+    auto decision = test.decide(llr, length);
+    if (decision == SequentialTest::UNDECIDED) return false;
+    has_mask = decision == SequentialTest::ACCEPT;
+    return true;
+  }
+
   int max_person = Config::get_extract().history_size;
   if (history.size() < max_person) return false;
 
@@ -542,29 +689,41 @@ void RecordTask::update_person_info(RecognizeData *input,
 
 void RecordTask::update_person_snapshot(RecognizeData *input,
                                         PersonData &person) {
-  MmzImage *bgr, *ir;
-  if (Config::get_user().upload_hd_snapshot) {
-    bgr = input->img_bgr_large;
-    ir = input->img_nir_large;
-  } else {
-    bgr = input->img_bgr_small;
-    ir = input->img_nir_small;
+  // deciding frame competes as well, it is the only one for a card
+  update_best_shot(input);
+  best_shot_.bgr.copyTo(person.bgr_snapshot);
+  best_shot_.nir.copyTo(person.nir_snapshot);
+
+  int width = best_shot_.bgr.cols;
+  int height = best_shot_.bgr.rows;
+  if (width == 0 || height == 0) {
+    person.face_snapshot = cv::Mat();
+    return;
   }
 
-  int width = bgr->width;
-  int height = bgr->height;
-  person.bgr_snapshot.create(height, width, CV_8UC3);
-  memcpy(person.bgr_snapshot.data, bgr->pData, width * height * 3 / 2);
-
-  static MmzImage *snapshot =
-      new MmzImage(width, height, SZ_IMAGETYPE_BGR_PACKAGE);
+  // upload_hd_snapshot switches between channels at runtime, buffers are
+  // reallocated once a larger snapshot comes
+  static MmzImage *frame = nullptr;
+  static MmzImage *snapshot = nullptr;
+  static int capacity = 0;
+  if (width * height > capacity) {
+    if (frame) delete frame;
+    if (snapshot) delete snapshot;
+    frame = new MmzImage(width, height, SZ_IMAGETYPE_NV21);
+    snapshot = new MmzImage(width, height, SZ_IMAGETYPE_BGR_PACKAGE);
+    capacity = width * height;
+  }
+  frame->set_size(width, height);
   snapshot->set_size(width, height);
-  if (input->bgr_face_detected_ && width < height &&
-      Ive::getInstance()->yuv2RgbPacked(snapshot, bgr, true)) {
-    int crop_x = input->bgr_detection_.x * width;
-    int crop_y = input->bgr_detection_.y * height;
-    int crop_w = input->bgr_detection_.width * width;
-    int crop_h = input->bgr_detection_.height * height;
+  memcpy(frame->pData, best_shot_.bgr.data, width * height * 3 / 2);
+
+  // convert only the chosen frame
+  if (best_shot_.face_detected && width < height &&
+      Ive::getInstance()->yuv2RgbPacked(snapshot, frame, true)) {
+    int crop_x = best_shot_.detection.x * width;
+    int crop_y = best_shot_.detection.y * height;
+    int crop_w = best_shot_.detection.width * width;
+    int crop_h = best_shot_.detection.height * height;
 
     crop_x = std::max(0, crop_x - crop_w / 2);
     crop_y = std::max(0, crop_y - crop_h / 4);
@@ -576,11 +735,55 @@ void RecordTask::update_person_snapshot(RecognizeData *input,
         .copyTo(person.face_snapshot);
   } else
     person.face_snapshot = cv::Mat();
+}
 
-  width = ir->width;
-  height = ir->height;
-  person.nir_snapshot.create(height, width, CV_8UC3);
-  memcpy(person.nir_snapshot.data, ir->pData, width * height * 3 / 2);
+void RecordTask::update_best_shot(RecognizeData *input) {
+  // quality ranks frames by sharpness, exposure, size and pose
+  float quality = 0;
+  if (input->bgr_face_detected_)
+    quality =
+        FaceQuality::evaluate(input->img_bgr_small, input->bgr_detection_);
+  if (best_shot_.valid && quality <= best_shot_.quality) return;
+
+  MmzImage *bgr, *ir;
+  if (Config::get_user().upload_hd_snapshot && input->has_large) {
+    bgr = input->img_bgr_large;
+    ir = input->img_nir_large;
+  } else {
+    bgr = input->img_bgr_small;
+    ir = input->img_nir_small;
+  }
+
+  // raw copies only, conversion waits for the decision
+  best_shot_.bgr.create(bgr->height, bgr->width, CV_8UC3);
+  memcpy(best_shot_.bgr.data, bgr->pData, bgr->width * bgr->height * 3 / 2);
+  best_shot_.nir.create(ir->height, ir->width, CV_8UC3);
+  memcpy(best_shot_.nir.data, ir->pData, ir->width * ir->height * 3 / 2);
+
+  best_shot_.valid = true;
+  best_shot_.quality = quality;
+  best_shot_.face_detected = input->bgr_face_detected_;
+  best_shot_.detection = input->bgr_detection_;
+}
+
+void RecordTask::alert_watchlist(RecognizeData *input) {
+  SZ_UINT32 face_id = watchlist_person_.face_id;
+
+  PersonData person;
+  person.score = watchlist_person_.score;
+  person.has_mask = input->has_mask;
+  update_person_info(input, face_id, person);
+  SZ_LOG_WARN("watchlist alert, id={}, score={:.2f}", face_id, person.score);
+
+  // decided for this visit, the track keeps the identity
+  emit tx_identity(input->bgr_track_id_, face_id);
+  if (duplicated_counter_ >= Config::get_user().duplication_limit) return;
+
+  int duration;
+  bool duplicated =
+      if_duplicated(face_id, input->person_feature, duration, person);
+  if (!duplicated) duplicated_counter_++;
+  emit tx_display(person, duplicated, duplicated);
 }
 
 bool RecordTask::if_duplicated(SZ_UINT32 &face_id, const FaceFeature &feature,
@@ -681,6 +884,13 @@ void RecordTask::rx_enable(bool enable) {
 }
 
 void RecordTask::rx_reset() {
+  reset_person();
+
+  track_histories_.clear();
+  track_id_ = 0;
+}
+
+void RecordTask::reset_person() {
   reset_recognize();
   reset_temperature();
 
@@ -6,15 +6,18 @@
 #include <QObject>
 #include <QTimer>
 
+#include "group_gallery.hpp"
 #include "person_service.hpp"
 #include "pingpang_buffer.hpp"
 #include "quface_common.hpp"
 #include "recognize_data.hpp"
+#include "sequential_test.hpp"
 
 namespace suanzi {
 
 class RecordTask : QObject {
   Q_OBJECT
+
  public:
   static RecordTask *get_instance();
   static bool idle();
@@ -36,6 +39,13 @@ class RecordTask : QObject {
   void tx_nir_finish(bool if_finished);
   void tx_bgr_finish(bool if_finished);
 
+  // for identity lock of a track
+  void tx_identity(uint track_id, uint face_id);
+
+  // for attribute cache of a track
+  void tx_liveness(uint track_id, bool is_live);
+  void tx_mask(uint track_id, bool has_mask);
+
   // for display
   void tx_display(PersonData person, bool audio_duplicated,
                   bool record_duplicated);
@@ -44,13 +54,21 @@ class RecordTask : QObject {
   RecordTask(QThread *thread = nullptr, QObject *parent = nullptr);
   ~RecordTask();
 
-  bool if_fresh(const FaceFeature &feature);
+  bool switch_track(SZ_UINT32 track_id, int frame_idx);
+  void reset_person();
   void reset_recognize();
   void reset_temperature();
 
   bool sequence_query(const std::vector<QueryResult> &person_history,
                       const std::vector<bool> &mask_history,
                       const bool has_mask, SZ_UINT32 &face_id, SZ_FLOAT &score);
+  bool query_pending(const std::vector<QueryResult> &person_history,
+                     const std::vector<bool> &mask_history,
+                     const bool has_mask);
+  SequentialTest::Decision sequential_query(
+      const std::vector<QueryResult> &person_history,
+      const std::vector<bool> &mask_history, const bool has_mask,
+      SZ_UINT32 &face_id, SZ_FLOAT &score);
   bool sequence_antispoof(const std::vector<bool> &history, bool &is_live);
   bool sequence_mask(const std::vector<bool> &history, bool &has_mask);
   bool sequence_temperature(SZ_UINT32 face_id, int duration,
@@ -65,6 +83,8 @@ class RecordTask : QObject {
   void update_person_info(RecognizeData *input, const std::string &card_no,
                           PersonData &person);
   void update_person_snapshot(RecognizeData *input, PersonData &person);
+  void update_best_shot(RecognizeData *input);
+  void alert_watchlist(RecognizeData *input);
 
   bool if_duplicated(SZ_UINT32 &face_id, const FaceFeature &feature,
                      int &duration, PersonData &person);
@@ -75,8 +95,41 @@ class RecordTask : QObject {
   PersonService::ptr person_service_;
 
   FaceDatabasePtr face_database_, unknown_database_;
+  GroupGallery group_gallery_;
+
+  // best face of the current visit by quality, snapshots are converted from
+  // it once the decision is made
+  typedef struct {
+    bool valid;
+    float quality;
+    bool face_detected;
+    DetectionRatio detection;
+    cv::Mat bgr;  // raw nv21
+    cv::Mat nir;  // raw nv21
+  } BestShot;
+  BestShot best_shot_;
+
+  // recognition state of other tracks in view, restored when they are
+  // selected again
+  typedef struct {
+    std::vector<QueryResult> person_history;
+    std::vector<bool> mask_history;
+    std::vector<bool> live_history;
+    BestShot best_shot;
+    bool watchlist_pending;
+    QueryResult watchlist_person;
+    int duplicated_counter;
+    int frame_idx;
+  } TrackHistory;
+  std::map<SZ_UINT32, TrackHistory> track_histories_;
+  SZ_UINT32 track_id_;
+  int track_frame_idx_;
 
   std::vector<QueryResult> person_history_;
+
+  // watchlist hit of the current track, alerted once liveness is decided
+  bool watchlist_pending_;
+  QueryResult watchlist_person_;
   std::vector<bool> mask_history_;
   std::map<SZ_UINT32, float> known_temperature_;
 
@@ -91,8 +144,6 @@ class RecordTask : QObject {
   SZ_UINT32 duplicated_id_;
   int duplicated_duration_;
 
-  FaceFeature latest_feature_;
-
   std::vector<float> temperature_history_;
   float latest_temperature_;
 
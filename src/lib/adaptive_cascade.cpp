@@ -0,0 +1,41 @@
+#include "adaptive_cascade.hpp"
+
+#include <algorithm>
+
+#include <quface/logger.hpp>
+
+using namespace suanzi;
+
+AdaptiveCascade::AdaptiveCascade(const std::string &name, int stage_count,
+                                 float decay)
+    : name_(name), decay_(decay) {
+  // no measurement yet, keep the given order
+  for (int i = 0; i < stage_count; i++) {
+    stages_.push_back({1.f, 0.5f});
+    order_.push_back(i);
+  }
+}
+
+std::vector<int> AdaptiveCascade::order() const { return order_; }
+
+void AdaptiveCascade::update(int stage, float ms, bool rejected) {
+  Stage &s = stages_[stage];
+  s.cost_ms += decay_ * (ms - s.cost_ms);
+  s.reject_rate += decay_ * ((rejected ? 1.f : 0.f) - s.reject_rate);
+  reorder();
+}
+
+void AdaptiveCascade::reorder() {
+  std::vector<int> order = order_;
+  std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+    return stages_[a].cost_ms / std::max(stages_[a].reject_rate, 0.01f) <
+           stages_[b].cost_ms / std::max(stages_[b].reject_rate, 0.01f);
+  });
+  if (order == order_) return;
+
+  order_.swap(order);
+  for (int stage : order_) {
+    SZ_LOG_DEBUG("{} stage={}: cost={:.2f}ms, reject={:.2f}", name_, stage,
+                 stages_[stage].cost_ms, stages_[stage].reject_rate);
+  }
+}
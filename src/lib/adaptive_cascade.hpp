@@ -0,0 +1,40 @@
+#ifndef ADAPTIVE_CASCADE_H
+#define ADAPTIVE_CASCADE_H
+
+#include <string>
+#include <vector>
+
+namespace suanzi {
+
+// Orders the stages of a reject-early cascade by measured cost per
+// rejection. Latency and rejection rate of each stage are tracked as moving
+// averages, so that the order minimising the expected cost per decision
+// follows the scene. Not thread safe.
+class AdaptiveCascade {
+ public:
+  AdaptiveCascade(const std::string &name, int stage_count,
+                  float decay = 0.05);
+
+  // stage indexes in the order they should run, a copy as update() may
+  // reorder while iterating
+  std::vector<int> order() const;
+
+  void update(int stage, float ms, bool rejected);
+
+ private:
+  typedef struct {
+    float cost_ms;
+    float reject_rate;
+  } Stage;
+
+  void reorder();
+
+  std::string name_;
+  float decay_;
+  std::vector<Stage> stages_;
+  std::vector<int> order_;
+};
+
+}  // namespace suanzi
+
+#endif
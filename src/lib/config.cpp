@@ -44,6 +44,7 @@ void suanzi::to_json(json &j, const UserConfig &c) {
   SAVE_JSON_TO(j, "ir_validate_score", c.ir_validate_score);
   SAVE_JSON_TO(j, "bgr_validate_score", c.bgr_validate_score);
   SAVE_JSON_TO(j, "wdr", c.wdr);
+  SAVE_JSON_TO(j, "access_groups", c.access_groups);
 }
 
 void suanzi::from_json(const json &j, UserConfig &c) {
@@ -90,6 +91,7 @@ void suanzi::from_json(const json &j, UserConfig &c) {
   LOAD_JSON_TO(j, "ir_validate_score", c.ir_validate_score);
   LOAD_JSON_TO(j, "bgr_validate_score", c.bgr_validate_score);
   LOAD_JSON_TO(j, "wdr", c.wdr);
+  LOAD_JSON_TO(j, "access_groups", c.access_groups);
 }
 
 void suanzi::to_json(json &j, const AppConfig &c) {
@@ -104,6 +106,18 @@ void suanzi::to_json(json &j, const AppConfig &c) {
   SAVE_JSON_TO(j, "boot_image_path", c.boot_image_path);
   SAVE_JSON_TO(j, "screensaver_image_path", c.screensaver_image_path);
   SAVE_JSON_TO(j, "has_touch_screen", c.has_touch_screen);
+  SAVE_JSON_TO(j, "adaptive_large_capture", c.adaptive_large_capture);
+  SAVE_JSON_TO(j, "face_exposure_control", c.face_exposure_control);
+  SAVE_JSON_TO(j, "target_face_luminance", c.target_face_luminance);
+  SAVE_JSON_TO(j, "exposure_update_interval", c.exposure_update_interval);
+  SAVE_JSON_TO(j, "max_exposure_step", c.max_exposure_step);
+  SAVE_JSON_TO(j, "min_exposure_compensation", c.min_exposure_compensation);
+  SAVE_JSON_TO(j, "max_exposure_compensation", c.max_exposure_compensation);
+  SAVE_JSON_TO(j, "latency_governor", c.latency_governor);
+  SAVE_JSON_TO(j, "target_latency_ms", c.target_latency_ms);
+  SAVE_JSON_TO(j, "governor_window", c.governor_window);
+  SAVE_JSON_TO(j, "predict_nir_face", c.predict_nir_face);
+  SAVE_JSON_TO(j, "nir_calibration_frames", c.nir_calibration_frames);
 }
 
 void suanzi::from_json(const json &j, AppConfig &c) {
@@ -118,6 +132,18 @@ void suanzi::from_json(const json &j, AppConfig &c) {
   LOAD_JSON_TO(j, "boot_image_path", c.boot_image_path);
   LOAD_JSON_TO(j, "screensaver_image_path", c.screensaver_image_path);
   LOAD_JSON_TO(j, "has_touch_screen", c.has_touch_screen);
+  LOAD_JSON_TO(j, "adaptive_large_capture", c.adaptive_large_capture);
+  LOAD_JSON_TO(j, "face_exposure_control", c.face_exposure_control);
+  LOAD_JSON_TO(j, "target_face_luminance", c.target_face_luminance);
+  LOAD_JSON_TO(j, "exposure_update_interval", c.exposure_update_interval);
+  LOAD_JSON_TO(j, "max_exposure_step", c.max_exposure_step);
+  LOAD_JSON_TO(j, "min_exposure_compensation", c.min_exposure_compensation);
+  LOAD_JSON_TO(j, "max_exposure_compensation", c.max_exposure_compensation);
+  LOAD_JSON_TO(j, "latency_governor", c.latency_governor);
+  LOAD_JSON_TO(j, "target_latency_ms", c.target_latency_ms);
+  LOAD_JSON_TO(j, "governor_window", c.governor_window);
+  LOAD_JSON_TO(j, "predict_nir_face", c.predict_nir_face);
+  LOAD_JSON_TO(j, "nir_calibration_frames", c.nir_calibration_frames);
 }
 
 void suanzi::to_json(json &j, const TemperatureConfig &c) {
@@ -162,6 +188,7 @@ void suanzi::to_json(json &j, const QufaceConfig &c) {
   SAVE_JSON_TO(j, "device_secret", c.device_secret);
   SAVE_JSON_TO(j, "client_id", c.client_id);
   SAVE_JSON_TO(j, "db_name", c.db_name);
+  SAVE_JSON_TO(j, "unknown_db_name", c.unknown_db_name);
   SAVE_JSON_TO(j, "model_file_path", c.model_file_path);
   SAVE_JSON_TO(j, "license_filename", c.license_filename);
 }
@@ -172,6 +199,7 @@ void suanzi::from_json(const json &j, QufaceConfig &c) {
   LOAD_JSON_TO(j, "device_secret", c.device_secret);
   LOAD_JSON_TO(j, "client_id", c.client_id);
   LOAD_JSON_TO(j, "db_name", c.db_name);
+  LOAD_JSON_TO(j, "unknown_db_name", c.unknown_db_name);
   LOAD_JSON_TO(j, "model_file_path", c.model_file_path);
   LOAD_JSON_TO(j, "license_filename", c.license_filename);
 }
@@ -180,12 +208,14 @@ void suanzi::to_json(json &j, const CameraConfig &c) {
   SAVE_JSON_TO(j, "index", c.index);
   SAVE_JSON_TO(j, "rotate", c.rotate);
   SAVE_JSON_TO(j, "flip", c.flip);
+  SAVE_JSON_TO(j, "mapping", c.mapping);
 }
 
 void suanzi::from_json(const json &j, CameraConfig &c) {
   LOAD_JSON_TO(j, "index", c.index);
   LOAD_JSON_TO(j, "rotate", c.rotate);
   LOAD_JSON_TO(j, "flip", c.flip);
+  LOAD_JSON_TO(j, "mapping", c.mapping);
 }
 
 void suanzi::to_json(json &j, const DetectConfig &c) {
@@ -199,6 +229,24 @@ void suanzi::to_json(json &j, const DetectConfig &c) {
   SAVE_JSON_TO(j, "min_roll", c.min_roll);
   SAVE_JSON_TO(j, "min_tracking_iou", c.min_tracking_iou);
   SAVE_JSON_TO(j, "min_tracking_number", c.min_tracking_number);
+  SAVE_JSON_TO(j, "max_tracking_faces", c.max_tracking_faces);
+  SAVE_JSON_TO(j, "max_tracking_lost", c.max_tracking_lost);
+  SAVE_JSON_TO(j, "min_matching_iou", c.min_matching_iou);
+  SAVE_JSON_TO(j, "skip_nir_without_bgr", c.skip_nir_without_bgr);
+  SAVE_JSON_TO(j, "full_detect_interval", c.full_detect_interval);
+  SAVE_JSON_TO(j, "roi_expand_ratio", c.roi_expand_ratio);
+  SAVE_JSON_TO(j, "pose_refresh_interval", c.pose_refresh_interval);
+  SAVE_JSON_TO(j, "max_pose_shift", c.max_pose_shift);
+  SAVE_JSON_TO(j, "max_candidate_faces", c.max_candidate_faces);
+  SAVE_JSON_TO(j, "schedule_wait_weight", c.schedule_wait_weight);
+  SAVE_JSON_TO(j, "schedule_identified_penalty",
+               c.schedule_identified_penalty);
+  SAVE_JSON_TO(j, "select_modality", c.select_modality);
+  SAVE_JSON_TO(j, "dark_luminance", c.dark_luminance);
+  SAVE_JSON_TO(j, "bright_luminance", c.bright_luminance);
+  SAVE_JSON_TO(j, "luminance_hysteresis", c.luminance_hysteresis);
+  SAVE_JSON_TO(j, "far_field_detection", c.far_field_detection);
+  SAVE_JSON_TO(j, "far_field_tiles_per_frame", c.far_field_tiles_per_frame);
 }
 
 void suanzi::from_json(const json &j, DetectConfig &c) {
@@ -212,6 +260,24 @@ void suanzi::from_json(const json &j, DetectConfig &c) {
   LOAD_JSON_TO(j, "min_roll", c.min_roll);
   LOAD_JSON_TO(j, "min_tracking_iou", c.min_tracking_iou);
   LOAD_JSON_TO(j, "min_tracking_number", c.min_tracking_number);
+  LOAD_JSON_TO(j, "max_tracking_faces", c.max_tracking_faces);
+  LOAD_JSON_TO(j, "max_tracking_lost", c.max_tracking_lost);
+  LOAD_JSON_TO(j, "min_matching_iou", c.min_matching_iou);
+  LOAD_JSON_TO(j, "skip_nir_without_bgr", c.skip_nir_without_bgr);
+  LOAD_JSON_TO(j, "full_detect_interval", c.full_detect_interval);
+  LOAD_JSON_TO(j, "roi_expand_ratio", c.roi_expand_ratio);
+  LOAD_JSON_TO(j, "pose_refresh_interval", c.pose_refresh_interval);
+  LOAD_JSON_TO(j, "max_pose_shift", c.max_pose_shift);
+  LOAD_JSON_TO(j, "max_candidate_faces", c.max_candidate_faces);
+  LOAD_JSON_TO(j, "schedule_wait_weight", c.schedule_wait_weight);
+  LOAD_JSON_TO(j, "schedule_identified_penalty",
+               c.schedule_identified_penalty);
+  LOAD_JSON_TO(j, "select_modality", c.select_modality);
+  LOAD_JSON_TO(j, "dark_luminance", c.dark_luminance);
+  LOAD_JSON_TO(j, "bright_luminance", c.bright_luminance);
+  LOAD_JSON_TO(j, "luminance_hysteresis", c.luminance_hysteresis);
+  LOAD_JSON_TO(j, "far_field_detection", c.far_field_detection);
+  LOAD_JSON_TO(j, "far_field_tiles_per_frame", c.far_field_tiles_per_frame);
 }
 
 void suanzi::to_json(json &j, const ExtractConfig &c) {
@@ -220,6 +286,25 @@ void suanzi::to_json(json &j, const ExtractConfig &c) {
   SAVE_JSON_TO(j, "min_recognize_score", c.min_recognize_score);
   SAVE_JSON_TO(j, "min_accumulate_score", c.min_accumulate_score);
   SAVE_JSON_TO(j, "max_lost_age", c.max_lost_age);
+  SAVE_JSON_TO(j, "quality_window", c.quality_window);
+  SAVE_JSON_TO(j, "min_quality_gain", c.min_quality_gain);
+  SAVE_JSON_TO(j, "identity_verify_interval", c.identity_verify_interval);
+  SAVE_JSON_TO(j, "max_identity_shift", c.max_identity_shift);
+  SAVE_JSON_TO(j, "attribute_verify_interval", c.attribute_verify_interval);
+  SAVE_JSON_TO(j, "max_attribute_shift", c.max_attribute_shift);
+  SAVE_JSON_TO(j, "min_eye_distance", c.min_eye_distance);
+  SAVE_JSON_TO(j, "min_mask_eye_distance", c.min_mask_eye_distance);
+  SAVE_JSON_TO(j, "fusion_size", c.fusion_size);
+  SAVE_JSON_TO(j, "sequential_test", c.sequential_test);
+  SAVE_JSON_TO(j, "false_accept_rate", c.false_accept_rate);
+  SAVE_JSON_TO(j, "false_reject_rate", c.false_reject_rate);
+  SAVE_JSON_TO(j, "score_llr_slope", c.score_llr_slope);
+  SAVE_JSON_TO(j, "mask_accuracy", c.mask_accuracy);
+  SAVE_JSON_TO(j, "max_test_length", c.max_test_length);
+  SAVE_JSON_TO(j, "reentry_cache_size", c.reentry_cache_size);
+  SAVE_JSON_TO(j, "reentry_ttl", c.reentry_ttl);
+  SAVE_JSON_TO(j, "min_reentry_score", c.min_reentry_score);
+  SAVE_JSON_TO(j, "min_watchlist_score", c.min_watchlist_score);
 }
 
 void suanzi::from_json(const json &j, ExtractConfig &c) {
@@ -228,6 +313,25 @@ void suanzi::from_json(const json &j, ExtractConfig &c) {
   LOAD_JSON_TO(j, "min_recognize_score", c.min_recognize_score);
   LOAD_JSON_TO(j, "min_accumulate_score", c.min_accumulate_score);
   LOAD_JSON_TO(j, "max_lost_age", c.max_lost_age);
+  LOAD_JSON_TO(j, "quality_window", c.quality_window);
+  LOAD_JSON_TO(j, "min_quality_gain", c.min_quality_gain);
+  LOAD_JSON_TO(j, "identity_verify_interval", c.identity_verify_interval);
+  LOAD_JSON_TO(j, "max_identity_shift", c.max_identity_shift);
+  LOAD_JSON_TO(j, "attribute_verify_interval", c.attribute_verify_interval);
+  LOAD_JSON_TO(j, "max_attribute_shift", c.max_attribute_shift);
+  LOAD_JSON_TO(j, "min_eye_distance", c.min_eye_distance);
+  LOAD_JSON_TO(j, "min_mask_eye_distance", c.min_mask_eye_distance);
+  LOAD_JSON_TO(j, "fusion_size", c.fusion_size);
+  LOAD_JSON_TO(j, "sequential_test", c.sequential_test);
+  LOAD_JSON_TO(j, "false_accept_rate", c.false_accept_rate);
+  LOAD_JSON_TO(j, "false_reject_rate", c.false_reject_rate);
+  LOAD_JSON_TO(j, "score_llr_slope", c.score_llr_slope);
+  LOAD_JSON_TO(j, "mask_accuracy", c.mask_accuracy);
+  LOAD_JSON_TO(j, "max_test_length", c.max_test_length);
+  LOAD_JSON_TO(j, "reentry_cache_size", c.reentry_cache_size);
+  LOAD_JSON_TO(j, "reentry_ttl", c.reentry_ttl);
+  LOAD_JSON_TO(j, "min_reentry_score", c.min_reentry_score);
+  LOAD_JSON_TO(j, "min_watchlist_score", c.min_watchlist_score);
 }
 
 void suanzi::to_json(json &j, const LivenessConfig &c) {
@@ -241,6 +345,15 @@ void suanzi::to_json(json &j, const LivenessConfig &c) {
                c.min_height_ratio_between_bgr);
   SAVE_JSON_TO(j, "max_height_ratio_between_bgr",
                c.max_height_ratio_between_bgr);
+  SAVE_JSON_TO(j, "min_eye_distance", c.min_eye_distance);
+  SAVE_JSON_TO(j, "sequential_test", c.sequential_test);
+  SAVE_JSON_TO(j, "false_accept_rate", c.false_accept_rate);
+  SAVE_JSON_TO(j, "false_reject_rate", c.false_reject_rate);
+  SAVE_JSON_TO(j, "live_accuracy", c.live_accuracy);
+  SAVE_JSON_TO(j, "max_test_length", c.max_test_length);
+  SAVE_JSON_TO(j, "nir_precheck", c.nir_precheck);
+  SAVE_JSON_TO(j, "min_nir_brightness", c.min_nir_brightness);
+  SAVE_JSON_TO(j, "min_nir_contrast", c.min_nir_contrast);
 }
 
 void suanzi::from_json(const json &j, LivenessConfig &c) {
@@ -254,6 +367,15 @@ void suanzi::from_json(const json &j, LivenessConfig &c) {
                c.min_height_ratio_between_bgr);
   LOAD_JSON_TO(j, "max_height_ratio_between_bgr",
                c.max_height_ratio_between_bgr);
+  LOAD_JSON_TO(j, "min_eye_distance", c.min_eye_distance);
+  LOAD_JSON_TO(j, "sequential_test", c.sequential_test);
+  LOAD_JSON_TO(j, "false_accept_rate", c.false_accept_rate);
+  LOAD_JSON_TO(j, "false_reject_rate", c.false_reject_rate);
+  LOAD_JSON_TO(j, "live_accuracy", c.live_accuracy);
+  LOAD_JSON_TO(j, "max_test_length", c.max_test_length);
+  LOAD_JSON_TO(j, "nir_precheck", c.nir_precheck);
+  LOAD_JSON_TO(j, "min_nir_brightness", c.min_nir_brightness);
+  LOAD_JSON_TO(j, "min_nir_contrast", c.min_nir_contrast);
 }
 
 void suanzi::from_json(const json &j, ConfigData &c) {
@@ -311,6 +433,18 @@ void Config::load_defaults(ConfigData &c) {
       .boot_image_path = "boot.jpg",
       .screensaver_image_path = "background.jpg",
       .has_touch_screen = false,
+      .adaptive_large_capture = false,
+      .face_exposure_control = false,
+      .target_face_luminance = 110,
+      .exposure_update_interval = 3,
+      .max_exposure_step = 6,
+      .min_exposure_compensation = 40,
+      .max_exposure_compensation = 120,
+      .latency_governor = false,
+      .target_latency_ms = 200,
+      .governor_window = 15,
+      .predict_nir_face = false,
+      .nir_calibration_frames = 100,
   };
 
   c.temperature = {
@@ -369,6 +503,7 @@ void Config::load_defaults(ConfigData &c) {
       .ir_validate_score = 0.1,
       .bgr_validate_score = 0.1,
       .wdr = false,
+      .access_groups = {},
   };
 
   c.quface = {
@@ -377,6 +512,7 @@ void Config::load_defaults(ConfigData &c) {
       .device_secret = "",
       .client_id = "face-service",
       .db_name = APP_DIR_PREFIX "/var/db/quface",
+      .unknown_db_name = "_UNKNOWN_DB_",
       .model_file_path = "facemodel.bin",
       .license_filename = "license.json",
   };
@@ -385,12 +521,14 @@ void Config::load_defaults(ConfigData &c) {
       .index = 1,
       .rotate = 1,
       .flip = 1,
+      .mapping = {},
   };
 
   c.infrared = {
       .index = 0,
       .rotate = 1,
       .flip = 1,
+      .mapping = {},
   };
 
   c.detect_levels_ = {
@@ -406,6 +544,23 @@ void Config::load_defaults(ConfigData &c) {
               .max_roll = 10,
               .min_tracking_iou = 0.9,
               .min_tracking_number = 3,
+              .max_tracking_faces = 5,
+              .max_tracking_lost = 5,
+              .min_matching_iou = 0.3,
+              .skip_nir_without_bgr = false,
+              .full_detect_interval = 8,
+              .roi_expand_ratio = 0.5,
+              .pose_refresh_interval = 5,
+              .max_pose_shift = 0.08,
+              .max_candidate_faces = 3,
+              .schedule_wait_weight = 0.2,
+              .schedule_identified_penalty = 1,
+              .select_modality = false,
+              .dark_luminance = 35,
+              .bright_luminance = 110,
+              .luminance_hysteresis = 8,
+              .far_field_detection = false,
+              .far_field_tiles_per_frame = 1,
           },
       .medium =
           {
@@ -419,6 +574,23 @@ void Config::load_defaults(ConfigData &c) {
               .max_roll = 15,
               .min_tracking_iou = 0.9,
               .min_tracking_number = 3,
+              .max_tracking_faces = 5,
+              .max_tracking_lost = 5,
+              .min_matching_iou = 0.3,
+              .skip_nir_without_bgr = false,
+              .full_detect_interval = 8,
+              .roi_expand_ratio = 0.5,
+              .pose_refresh_interval = 5,
+              .max_pose_shift = 0.08,
+              .max_candidate_faces = 3,
+              .schedule_wait_weight = 0.2,
+              .schedule_identified_penalty = 1,
+              .select_modality = false,
+              .dark_luminance = 35,
+              .bright_luminance = 110,
+              .luminance_hysteresis = 8,
+              .far_field_detection = false,
+              .far_field_tiles_per_frame = 1,
           },
       .low =
           {
@@ -432,6 +604,23 @@ void Config::load_defaults(ConfigData &c) {
               .max_roll = 15,
               .min_tracking_iou = 0.85,
               .min_tracking_number = 2,
+              .max_tracking_faces = 5,
+              .max_tracking_lost = 5,
+              .min_matching_iou = 0.3,
+              .skip_nir_without_bgr = false,
+              .full_detect_interval = 8,
+              .roi_expand_ratio = 0.5,
+              .pose_refresh_interval = 5,
+              .max_pose_shift = 0.08,
+              .max_candidate_faces = 3,
+              .schedule_wait_weight = 0.2,
+              .schedule_identified_penalty = 1,
+              .select_modality = false,
+              .dark_luminance = 35,
+              .bright_luminance = 110,
+              .luminance_hysteresis = 8,
+              .far_field_detection = false,
+              .far_field_tiles_per_frame = 1,
           },
   };
 
@@ -443,6 +632,25 @@ void Config::load_defaults(ConfigData &c) {
               .min_recognize_score = .8f,
               .min_accumulate_score = 1.6f,
               .max_lost_age = 20,
+              .quality_window = 5,
+              .min_quality_gain = 0.02,
+              .identity_verify_interval = 30,
+              .max_identity_shift = 0.3,
+              .attribute_verify_interval = 45,
+              .max_attribute_shift = 0.5,
+              .min_eye_distance = 36,
+              .min_mask_eye_distance = 20,
+              .fusion_size = 1,
+              .sequential_test = false,
+              .false_accept_rate = 0.001,
+              .false_reject_rate = 0.05,
+              .score_llr_slope = 50,
+              .mask_accuracy = 0.95,
+              .max_test_length = 8,
+              .reentry_cache_size = 32,
+              .reentry_ttl = 600,
+              .min_reentry_score = .9f,
+              .min_watchlist_score = .85f,
           },
       .medium =
           {
@@ -451,6 +659,25 @@ void Config::load_defaults(ConfigData &c) {
               .min_recognize_score = .8f,
               .min_accumulate_score = .8f,
               .max_lost_age = 20,
+              .quality_window = 5,
+              .min_quality_gain = 0.02,
+              .identity_verify_interval = 30,
+              .max_identity_shift = 0.3,
+              .attribute_verify_interval = 45,
+              .max_attribute_shift = 0.5,
+              .min_eye_distance = 36,
+              .min_mask_eye_distance = 20,
+              .fusion_size = 1,
+              .sequential_test = false,
+              .false_accept_rate = 0.01,
+              .false_reject_rate = 0.05,
+              .score_llr_slope = 50,
+              .mask_accuracy = 0.95,
+              .max_test_length = 8,
+              .reentry_cache_size = 32,
+              .reentry_ttl = 600,
+              .min_reentry_score = .9f,
+              .min_watchlist_score = .85f,
           },
       .low =
           {
@@ -459,6 +686,25 @@ void Config::load_defaults(ConfigData &c) {
               .min_recognize_score = .775f,
               .min_accumulate_score = .775f,
               .max_lost_age = 20,
+              .quality_window = 5,
+              .min_quality_gain = 0.02,
+              .identity_verify_interval = 30,
+              .max_identity_shift = 0.3,
+              .attribute_verify_interval = 45,
+              .max_attribute_shift = 0.5,
+              .min_eye_distance = 36,
+              .min_mask_eye_distance = 20,
+              .fusion_size = 1,
+              .sequential_test = false,
+              .false_accept_rate = 0.02,
+              .false_reject_rate = 0.05,
+              .score_llr_slope = 50,
+              .mask_accuracy = 0.95,
+              .max_test_length = 8,
+              .reentry_cache_size = 32,
+              .reentry_ttl = 600,
+              .min_reentry_score = .9f,
+              .min_watchlist_score = .85f,
           },
   };
 
@@ -473,6 +719,15 @@ void Config::load_defaults(ConfigData &c) {
               .max_width_ratio_between_bgr = 2.f,
               .min_height_ratio_between_bgr = .5f,
               .max_height_ratio_between_bgr = 2.f,
+              .min_eye_distance = 28,
+              .sequential_test = false,
+              .false_accept_rate = 0.001,
+              .false_reject_rate = 0.05,
+              .live_accuracy = 0.9,
+              .max_test_length = 10,
+              .nir_precheck = false,
+              .min_nir_brightness = 16,
+              .min_nir_contrast = 4,
           },
       .medium =
           {
@@ -484,6 +739,15 @@ void Config::load_defaults(ConfigData &c) {
               .max_width_ratio_between_bgr = 2.f,
               .min_height_ratio_between_bgr = .5f,
               .max_height_ratio_between_bgr = 2.f,
+              .min_eye_distance = 28,
+              .sequential_test = false,
+              .false_accept_rate = 0.01,
+              .false_reject_rate = 0.05,
+              .live_accuracy = 0.9,
+              .max_test_length = 10,
+              .nir_precheck = false,
+              .min_nir_brightness = 16,
+              .min_nir_contrast = 4,
           },
       .low =
           {
@@ -495,6 +759,15 @@ void Config::load_defaults(ConfigData &c) {
               .max_width_ratio_between_bgr = 2.f,
               .min_height_ratio_between_bgr = .5f,
               .max_height_ratio_between_bgr = 2.f,
+              .min_eye_distance = 28,
+              .sequential_test = false,
+              .false_accept_rate = 0.02,
+              .false_reject_rate = 0.05,
+              .live_accuracy = 0.9,
+              .max_test_length = 10,
+              .nir_precheck = false,
+              .min_nir_brightness = 16,
+              .min_nir_contrast = 4,
           },
   };
 }
@@ -847,6 +1120,17 @@ float Config::get_temperature_bias() {
          instance_.cfg_data_.user.temperature_bias;
 }
 
+void Config::set_nir_mapping(const std::vector<SZ_FLOAT> &mapping) {
+  std::unique_lock<std::mutex> lock(instance_.cfg_mutex_);
+  instance_.cfg_data_.infrared.mapping = mapping;
+}
+
+std::vector<SZ_FLOAT> Config::get_nir_mapping() {
+  // copied under the lock, calibration may replace it at any time
+  std::unique_lock<std::mutex> lock(instance_.cfg_mutex_);
+  return instance_.cfg_data_.infrared.mapping;
+}
+
 const ConfigData &Config::get_all() {
   std::unique_lock<std::mutex> lock(instance_.cfg_mutex_);
   return instance_.cfg_data_;
@@ -79,6 +79,8 @@ typedef struct {
   SZ_FLOAT ir_validate_score;
   SZ_FLOAT bgr_validate_score;
   bool wdr;
+  // people outside these groups are not searched, empty for everyone
+  std::vector<std::string> access_groups;
 } UserConfig;
 
 void to_json(json &j, const UserConfig &c);
@@ -102,6 +104,18 @@ typedef struct {
   std::string boot_image_path;
   std::string screensaver_image_path;
   bool has_touch_screen;
+  bool adaptive_large_capture;
+  bool face_exposure_control;
+  SZ_FLOAT target_face_luminance;
+  SZ_INT32 exposure_update_interval;
+  SZ_INT32 max_exposure_step;
+  SZ_INT32 min_exposure_compensation;
+  SZ_INT32 max_exposure_compensation;
+  bool latency_governor;
+  SZ_INT32 target_latency_ms;
+  SZ_INT32 governor_window;
+  bool predict_nir_face;
+  SZ_INT32 nir_calibration_frames;
 } AppConfig;
 
 void to_json(json &j, const AppConfig &c);
@@ -142,6 +156,7 @@ typedef struct {
   std::string device_secret;
   std::string client_id;
   std::string db_name;
+  std::string unknown_db_name;  // strangers seen recently
   std::string model_file_path;
   std::string license_filename;
 } QufaceConfig;
@@ -160,6 +175,23 @@ typedef struct {
   SZ_FLOAT max_roll;
   SZ_FLOAT min_tracking_iou;
   SZ_UINT32 min_tracking_number;
+  SZ_UINT32 max_tracking_faces;
+  SZ_UINT32 max_tracking_lost;
+  SZ_FLOAT min_matching_iou;
+  bool skip_nir_without_bgr;
+  SZ_UINT32 full_detect_interval;
+  SZ_FLOAT roi_expand_ratio;
+  SZ_UINT32 pose_refresh_interval;
+  SZ_FLOAT max_pose_shift;
+  SZ_INT32 max_candidate_faces;
+  SZ_FLOAT schedule_wait_weight;
+  SZ_FLOAT schedule_identified_penalty;
+  bool select_modality;
+  SZ_FLOAT dark_luminance;
+  SZ_FLOAT bright_luminance;
+  SZ_FLOAT luminance_hysteresis;
+  bool far_field_detection;
+  SZ_INT32 far_field_tiles_per_frame;
 } DetectConfig;
 
 void to_json(json &j, const DetectConfig &c);
@@ -171,6 +203,25 @@ typedef struct {
   SZ_FLOAT min_recognize_score;
   SZ_FLOAT min_accumulate_score;
   SZ_INT32 max_lost_age;
+  SZ_INT32 quality_window;
+  SZ_FLOAT min_quality_gain;
+  SZ_INT32 identity_verify_interval;
+  SZ_FLOAT max_identity_shift;
+  SZ_INT32 attribute_verify_interval;
+  SZ_FLOAT max_attribute_shift;
+  SZ_FLOAT min_eye_distance;
+  SZ_FLOAT min_mask_eye_distance;
+  SZ_INT32 fusion_size;
+  bool sequential_test;
+  SZ_FLOAT false_accept_rate;
+  SZ_FLOAT false_reject_rate;
+  SZ_FLOAT score_llr_slope;
+  SZ_FLOAT mask_accuracy;
+  SZ_INT32 max_test_length;
+  SZ_INT32 reentry_cache_size;
+  SZ_INT32 reentry_ttl;
+  SZ_FLOAT min_reentry_score;
+  SZ_FLOAT min_watchlist_score;
 } ExtractConfig;
 
 void to_json(json &j, const ExtractConfig &c);
@@ -185,6 +236,15 @@ typedef struct {
   SZ_FLOAT max_width_ratio_between_bgr;
   SZ_FLOAT min_height_ratio_between_bgr;
   SZ_FLOAT max_height_ratio_between_bgr;
+  SZ_FLOAT min_eye_distance;
+  bool sequential_test;
+  SZ_FLOAT false_accept_rate;
+  SZ_FLOAT false_reject_rate;
+  SZ_FLOAT live_accuracy;
+  SZ_INT32 max_test_length;
+  bool nir_precheck;
+  SZ_FLOAT min_nir_brightness;
+  SZ_FLOAT min_nir_contrast;
 } LivenessConfig;
 
 void to_json(json &j, const LivenessConfig &c);
@@ -194,6 +254,8 @@ typedef struct {
   int index;
   int rotate;
   int flip;
+  // infrared only, affine bgr to nir mapping, empty until calibrated
+  std::vector<SZ_FLOAT> mapping;
 } CameraConfig;
 
 void to_json(json &j, const CameraConfig &c);
@@ -270,6 +332,8 @@ class Config : public ConfigEventEmitter {
   static bool display_temperature();
   static void set_temperature_finetune(float bias);
   static float get_temperature_bias();
+  static void set_nir_mapping(const std::vector<SZ_FLOAT> &mapping);
+  static std::vector<SZ_FLOAT> get_nir_mapping();
 
   static const ConfigData &get_all();
   static const UserConfig &get_user();
@@ -3,6 +3,7 @@
 #include <cmath>
 
 #include "config.hpp"
+#include "nir_mapping.hpp"
 
 using namespace suanzi;
 
@@ -22,18 +23,37 @@ void DetectionRatio::scale(int x_scale, int y_scale, FaceDetection &detection,
   pose.roll = roll;
 }
 
-bool DetectionRatio::is_overlap(DetectionRatio other) {
+float DetectionRatio::iou(DetectionRatio other) {
   float x1 = x, x2 = other.x;
   float y1 = y, y2 = other.y;
   float w1 = width, w2 = other.width;
   float h1 = height, h2 = other.height;
 
-  if (x1 > x2 + w2 || y1 > y2 + h2 || x1 + w1 < x2 || y1 + h1 < y2)
-    return false;
+  if (x1 > x2 + w2 || y1 > y2 + h2 || x1 + w1 < x2 || y1 + h1 < y2) return 0;
 
   float overlay_w = std::min(x1 + w1, x2 + w2) - std::max(x1, x2);
   float overlay_h = std::min(y1 + h1, y2 + h2) - std::max(y1, y2);
-  float iou = overlay_w * overlay_h / (w1 * h1 + w2 * h2) * 2;
+  return overlay_w * overlay_h / (w1 * h1 + w2 * h2) * 2;
+}
+
+float DetectionRatio::eye_distance(int width, int height) {
+  return std::hypot((landmark[1][0] - landmark[0][0]) * width,
+                    (landmark[1][1] - landmark[0][1]) * height);
+}
+
+bool DetectionRatio::is_overlap(DetectionRatio other) {
+  // compare in nir coordinates once the sensors are calibrated
+  DetectionRatio mapped;
+  if (NirMapping::map(Config::get_nir_mapping(), other, mapped))
+    other = mapped;
+
+  float x1 = x, x2 = other.x;
+  float y1 = y, y2 = other.y;
+  float w1 = width, w2 = other.width;
+  float h1 = height, h2 = other.height;
+
+  float iou = this->iou(other);
+  if (iou <= 0) return false;
 
   auto cfg = Config::get_liveness();
   bool ret = iou > cfg.min_iou_between_bgr &&
@@ -97,6 +117,8 @@ DetectionData::DetectionData() {
 
   bgr_face_valid_ = false;
   nir_face_valid_ = false;
+
+  bgr_track_id_ = 0;
 }
 
 DetectionData::DetectionData(const ImagePackage *pkg) : ImagePackage(pkg) {
@@ -105,6 +127,8 @@ DetectionData::DetectionData(const ImagePackage *pkg) : ImagePackage(pkg) {
 
   bgr_face_valid_ = false;
   nir_face_valid_ = false;
+
+  bgr_track_id_ = 0;
 }
 
 DetectionData::DetectionData(Size size_bgr_large, Size size_bgr_small,
@@ -116,6 +140,8 @@ DetectionData::DetectionData(Size size_bgr_large, Size size_bgr_small,
 
   bgr_face_valid_ = false;
   nir_face_valid_ = false;
+
+  bgr_track_id_ = 0;
 }
 
 DetectionData::~DetectionData() {}
@@ -2,7 +2,9 @@
 #define DETECTION_DATA_H
 
 #include <QMetaType>
+#include <vector>
 
+#include "face_context.hpp"
 #include "image_package.hpp"
 #include "quface/common.hpp"
 
@@ -20,12 +22,21 @@ struct DetectionRatio {
 
   void scale(int x_scale, int y_scale, FaceDetection &detection,
              FacePose &pose);
+  float iou(DetectionRatio other);
+  float eye_distance(int width, int height);
   bool is_overlap(DetectionRatio other);
   bool is_valid_pose();
   bool is_valid_position();
   bool is_valid_size();
 };
 
+struct TrackedFace {
+  SZ_UINT32 track_id;
+  DetectionRatio detection;
+  bool stable;
+  bool valid;
+};
+
 class DetectionData : public ImagePackage {
  public:
   DetectionData();
@@ -45,6 +56,15 @@ class DetectionData : public ImagePackage {
   DetectionRatio bgr_detection_;
   DetectionRatio nir_detection_;
 
+  // all tracked faces of bgr channel, largest first. The one scheduled for
+  // recognition is bgr_detection_
+  std::vector<TrackedFace> bgr_faces_;
+  SZ_UINT32 bgr_track_id_;
+
+  // chips of the selected bgr face cut from the large images, downstream
+  // models use them instead of the large images
+  FaceContext face_context_;
+
   bool bgr_face_detected_;
   bool nir_face_detected_;
 
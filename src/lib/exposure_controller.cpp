@@ -0,0 +1,103 @@
+#include "exposure_controller.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <mpi_ae.h>
+#include <quface/logger.hpp>
+
+#include "config.hpp"
+#include "face_quality.hpp"
+
+using namespace suanzi;
+
+ExposureController::ExposureController()
+    : inited_(false),
+      available_(false),
+      pipe_(0),
+      default_compensation_(0),
+      applied_compensation_(0),
+      compensation_(0),
+      integral_(0),
+      frames_(0) {}
+
+void ExposureController::update(const MmzImage *bgr,
+                                const DetectionRatio *face) {
+  auto cfg = Config::get_app();
+  if (!cfg.face_exposure_control || !init()) return;
+
+  // isp needs a few frames to settle after each change
+  if (++frames_ < cfg.exposure_update_interval) return;
+  frames_ = 0;
+
+  float delta;
+  float mean = 0, stddev = 0;
+  if (face != nullptr &&
+      FaceQuality::luma_statistics(
+          bgr, (face->x + face->width * 0.15) * bgr->width,
+          (face->y + face->height * 0.15) * bgr->height,
+          face->width * 0.7 * bgr->width, face->height * 0.7 * bgr->height,
+          mean, stddev)) {
+    const float kp = 0.2, ki = 0.02, max_integral = 400;
+    float error = cfg.target_face_luminance - mean;
+    integral_ = std::min(std::max(integral_ + error, -max_integral),
+                         max_integral);
+    delta = kp * error + ki * integral_;
+  } else {
+    integral_ = 0;
+    delta = (default_compensation_ - compensation_) * 0.2f;
+  }
+
+  float max_step = cfg.max_exposure_step;
+  delta = std::min(std::max(delta, -max_step), max_step);
+  compensation_ = std::min(
+      std::max(compensation_ + delta, (float)cfg.min_exposure_compensation),
+      (float)cfg.max_exposure_compensation);
+  if (face == nullptr &&
+      std::abs(compensation_ - default_compensation_) < 1)
+    compensation_ = default_compensation_;
+
+  int compensation = (int)(compensation_ + 0.5f);
+  if (compensation != applied_compensation_ && apply(compensation)) {
+    SZ_LOG_DEBUG("face={:.1f}, compensation {} --> {}",
+                 face != nullptr ? mean : -1.f, applied_compensation_,
+                 compensation);
+    applied_compensation_ = compensation;
+  }
+}
+
+bool ExposureController::init() {
+  if (inited_) return available_;
+  inited_ = true;
+
+  pipe_ = Config::get_camera(io::CAMERA_BGR).index;
+
+  ISP_EXPOSURE_ATTR_S attr;
+  HI_S32 ret = HI_MPI_ISP_GetExposureAttr(pipe_, &attr);
+  if (ret != HI_SUCCESS) {
+    SZ_LOG_WARN("Get exposure attr of pipe {} failed ret={:#x}", pipe_, ret);
+    return false;
+  }
+
+  default_compensation_ = attr.stAuto.u8Compensation;
+  applied_compensation_ = default_compensation_;
+  compensation_ = default_compensation_;
+  available_ = true;
+  return true;
+}
+
+bool ExposureController::apply(int compensation) {
+  ISP_EXPOSURE_ATTR_S attr;
+  HI_S32 ret = HI_MPI_ISP_GetExposureAttr(pipe_, &attr);
+  if (ret == HI_SUCCESS) {
+    attr.stAuto.u8Compensation = compensation;
+    ret = HI_MPI_ISP_SetExposureAttr(pipe_, &attr);
+  }
+
+  if (ret != HI_SUCCESS) {
+    SZ_LOG_WARN("Set exposure compensation of pipe {} failed ret={:#x}", pipe_,
+                ret);
+    return false;
+  }
+  return true;
+}
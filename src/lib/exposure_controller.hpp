@@ -0,0 +1,39 @@
+#ifndef EXPOSURE_CONTROLLER_H
+#define EXPOSURE_CONTROLLER_H
+
+#include <quface-io/mmzimage.hpp>
+
+#include "detection_data.hpp"
+
+namespace suanzi {
+using namespace io;
+
+// Meters the face instead of the whole scene, so that backlit faces reach a
+// usable brightness. A damped PI loop moves the auto exposure compensation of
+// the bgr ISP pipe towards target_face_luminance on the face, in steps of at
+// most max_exposure_step within the configured range, and drifts back to the
+// original compensation while no face is in view.
+class ExposureController {
+ public:
+  ExposureController();
+
+  // face is nullptr if no face is in view
+  void update(const MmzImage *bgr, const DetectionRatio *face);
+
+ private:
+  bool init();
+  bool apply(int compensation);
+
+  bool inited_;
+  bool available_;
+  int pipe_;
+  int default_compensation_;
+  int applied_compensation_;
+  float compensation_;
+  float integral_;
+  int frames_;
+};
+
+}  // namespace suanzi
+
+#endif
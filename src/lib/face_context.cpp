@@ -0,0 +1,88 @@
+#include "face_context.hpp"
+
+#include "detection_data.hpp"
+#include "image_utils.hpp"
+
+using namespace suanzi;
+
+FaceChip::FaceChip()
+    : valid(false), has_nir(false), eye_distance(0), capacity(0) {}
+
+bool FaceChip::build(const MmzImage *bgr, const MmzImage *nir,
+                     const DetectionRatio &detection, float padding) {
+  valid = false;
+  has_nir = false;
+
+  FaceDetection face;
+  DetectionRatio ratio = detection;
+  ratio.scale(bgr->width, bgr->height, face, pose);
+  eye_distance = ratio.eye_distance(bgr->width, bgr->height);
+
+  int width = face.bbox.width;
+  int height = face.bbox.height;
+  x = face.bbox.x;
+  y = face.bbox.y;
+  if (!ImageUtils::align_region(bgr, padding, x, y, width, height))
+    return false;
+
+  // a larger face gets new buffers, copies keep the old ones
+  if (bgr_chip == nullptr || width * height > capacity) {
+    bgr_chip = std::make_shared<MmzImage>(width, height, SZ_IMAGETYPE_NV21);
+    nir_chip.reset();
+    capacity = width * height;
+  }
+  ImageUtils::crop_nv21(bgr, x, y, width, height, bgr_chip.get());
+
+  // cameras are aligned, nir uses the same region
+  if (nir != nullptr && nir->width == bgr->width &&
+      nir->height == bgr->height) {
+    if (nir_chip == nullptr)
+      nir_chip = std::make_shared<MmzImage>(width, height, SZ_IMAGETYPE_NV21);
+    ImageUtils::crop_nv21(nir, x, y, width, height, nir_chip.get());
+    has_nir = true;
+  }
+
+  this->detection = face;
+  this->detection.bbox.x -= x;
+  this->detection.bbox.y -= y;
+  for (int i = 0; i < SZ_LANDMARK_NUM; i++) {
+    pose.landmarks.point[i].x -= x;
+    pose.landmarks.point[i].y -= y;
+  }
+
+  valid = true;
+  return true;
+}
+
+const SVP_IMAGE_S *FaceChip::bgr_image() const {
+  return (const SVP_IMAGE_S *)bgr_chip->pImplData;
+}
+
+const SVP_IMAGE_S *FaceChip::nir_image() const {
+  return (const SVP_IMAGE_S *)nir_chip->pImplData;
+}
+
+FaceContext::FaceContext() : valid(false) {}
+
+bool FaceContext::build(const MmzImage *bgr_small, const MmzImage *nir_small,
+                        const MmzImage *bgr_large, const MmzImage *nir_large,
+                        const DetectionRatio &detection,
+                        float min_eye_distance) {
+  valid = small.build(bgr_small, nir_small, detection);
+
+  large.valid = false;
+  if (valid && small.eye_distance < min_eye_distance && bgr_large != nullptr)
+    large.build(bgr_large, nir_large, detection);
+
+  return valid;
+}
+
+bool FaceContext::has_chip(float min_eye_distance) const {
+  return valid && (small.eye_distance >= min_eye_distance ||
+                   (large.valid && large.eye_distance >= min_eye_distance));
+}
+
+const FaceChip &FaceContext::chip(float min_eye_distance) const {
+  if (small.eye_distance >= min_eye_distance || !large.valid) return small;
+  return large;
+}
@@ -0,0 +1,71 @@
+#ifndef FACE_CONTEXT_H
+#define FACE_CONTEXT_H
+
+#include <memory>
+
+#include <quface-io/mmzimage.hpp>
+#include <quface/common.hpp>
+
+namespace suanzi {
+using namespace io;
+
+struct DetectionRatio;
+
+// Padded chip of a face cut from the bgr and nir images of one channel, with
+// detection and pose scaled into chip coordinates. Chip buffers fit the
+// largest chip cut so far and are reused, copies of a chip share them.
+class FaceChip {
+ public:
+  FaceChip();
+
+  bool build(const MmzImage *bgr, const MmzImage *nir,
+             const DetectionRatio &detection, float padding = 0.6);
+
+  const SVP_IMAGE_S *bgr_image() const;
+  const SVP_IMAGE_S *nir_image() const;
+
+ public:
+  bool valid;
+  bool has_nir;
+
+  FaceDetection detection;
+  FacePose pose;
+  float eye_distance;  // pixels
+
+  // chip origin in source image
+  int x;
+  int y;
+
+  std::shared_ptr<MmzImage> bgr_chip;
+  std::shared_ptr<MmzImage> nir_chip;
+  int capacity;  // pixels of chip buffers
+};
+
+// Face of one frame prepared once for every model. The chip of the small
+// channel is always cut, the one of the large channel only if the face is
+// too small for some model and the large images were captured.
+class FaceContext {
+ public:
+  FaceContext();
+
+  bool build(const MmzImage *bgr_small, const MmzImage *nir_small,
+             const MmzImage *bgr_large, const MmzImage *nir_large,
+             const DetectionRatio &detection, float min_eye_distance);
+
+  // some channel has enough pixels between eyes, models are not run on
+  // smaller faces
+  bool has_chip(float min_eye_distance) const;
+
+  // smallest channel with enough pixels between eyes
+  const FaceChip &chip(float min_eye_distance) const;
+
+ public:
+  bool valid;
+
+  FaceChip small;
+  FaceChip large;
+};
+
+}  // namespace suanzi
+
+#endif
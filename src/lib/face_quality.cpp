@@ -0,0 +1,89 @@
+#include "face_quality.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "config.hpp"
+
+using namespace suanzi;
+
+float FaceQuality::evaluate(const MmzImage *image, DetectionRatio detection) {
+  int width = image->width;
+  int height = image->height;
+
+  // inner part of the face, skips background and hair
+  int x1 = std::max(1, (int)((detection.x + detection.width * 0.15) * width));
+  int y1 = std::max(1, (int)((detection.y + detection.height * 0.15) * height));
+  int x2 = std::min(width - 1,
+                    (int)((detection.x + detection.width * 0.85) * width));
+  int y2 = std::min(height - 1,
+                    (int)((detection.y + detection.height * 0.85) * height));
+  if (x2 - x1 < 4 || y2 - y1 < 4) return 0;
+
+  const SZ_BYTE *luma = image->pData;
+
+  long sum = 0, square_sum = 0, laplacian_sum = 0;
+  for (int y = y1; y < y2; y++) {
+    const SZ_BYTE *row = luma + y * width;
+    for (int x = x1; x < x2; x++) {
+      int value = row[x];
+      sum += value;
+      square_sum += value * value;
+      laplacian_sum += std::abs(4 * value - row[x - 1] - row[x + 1] -
+                                row[x - width] - row[x + width]);
+    }
+  }
+
+  float count = (x2 - x1) * (y2 - y1);
+  float mean = sum / count;
+  float stddev = std::sqrt(std::max(square_sum / count - mean * mean, 0.f));
+
+  float sharpness = std::min(laplacian_sum / count / 24.f, 1.f);
+  float brightness = std::max(1 - std::abs(mean - 128) / 128, 0.f);
+  float contrast = std::min(stddev / 48.f, 1.f);
+  float size = std::min(detection.width / 0.4f, 1.f);
+
+  return 0.35f * sharpness + 0.1f * brightness + 0.1f * contrast +
+         0.2f * size + 0.25f * pose_score(detection);
+}
+
+bool FaceQuality::luma_statistics(const MmzImage *image, int x, int y,
+                                  int width, int height, float &mean,
+                                  float &stddev) {
+  int x1 = std::max(x, 0);
+  int y1 = std::max(y, 0);
+  int x2 = std::min(x + width, image->width);
+  int y2 = std::min(y + height, image->height);
+  if (x2 - x1 < 4 || y2 - y1 < 4) return false;
+
+  long sum = 0, square_sum = 0;
+  for (int j = y1; j < y2; j++) {
+    const SZ_BYTE *row = image->pData + j * image->width;
+    for (int i = x1; i < x2; i++) {
+      sum += row[i];
+      square_sum += row[i] * row[i];
+    }
+  }
+
+  float count = (x2 - x1) * (y2 - y1);
+  mean = sum / count;
+  stddev = std::sqrt(std::max(square_sum / count - mean * mean, 0.f));
+  return true;
+}
+
+float FaceQuality::pose_score(DetectionRatio detection) {
+  auto cfg = Config::get_detect();
+
+  if (std::isnan(detection.yaw) || std::isnan(detection.pitch) ||
+      std::isnan(detection.roll))
+    return 0;
+
+  float yaw = std::abs(detection.yaw) /
+              std::max(std::abs(cfg.min_yaw), std::abs(cfg.max_yaw));
+  float pitch = std::abs(detection.pitch) /
+                std::max(std::abs(cfg.min_pitch), std::abs(cfg.max_pitch));
+  float roll = std::abs(detection.roll) /
+               std::max(std::abs(cfg.min_roll), std::abs(cfg.max_roll));
+  return std::max(1 - std::max({yaw, pitch, roll}), 0.f);
+}
@@ -0,0 +1,29 @@
+#ifndef FACE_QUALITY_H
+#define FACE_QUALITY_H
+
+#include <quface-io/mmzimage.hpp>
+
+#include "detection_data.hpp"
+
+namespace suanzi {
+using namespace io;
+
+// Cheap quality score of a face in [0, 1], computed on CPU from the luma
+// plane of a NV21 image. It combines sharpness, exposure, face size and head
+// pose, and is meant to rank frames of the same person, not to compare
+// different people.
+class FaceQuality {
+ public:
+  static float evaluate(const MmzImage *image, DetectionRatio detection);
+
+  // mean and standard deviation of luma inside a pixel region
+  static bool luma_statistics(const MmzImage *image, int x, int y, int width,
+                              int height, float &mean, float &stddev);
+
+ private:
+  static float pose_score(DetectionRatio detection);
+};
+
+}  // namespace suanzi
+
+#endif
@@ -0,0 +1,127 @@
+#include "face_tracker.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+#include "config.hpp"
+
+using namespace suanzi;
+
+DetectionRatio FaceTrack::predict() const {
+  DetectionRatio predicted = detection;
+  float steps = lost_count + 1;
+  predicted.x += velocity[0] * steps;
+  predicted.y += velocity[1] * steps;
+  predicted.width = std::max(predicted.width + velocity[2] * steps, 0.f);
+  predicted.height = std::max(predicted.height + velocity[3] * steps, 0.f);
+  return predicted;
+}
+
+FaceTracker::FaceTracker() : next_id_(1) {}
+
+void FaceTracker::update(const std::vector<DetectionRatio> &detections,
+                         std::vector<SZ_UINT32> &track_ids) {
+  auto cfg = Config::get_detect();
+
+  track_ids.assign(detections.size(), 0);
+
+  // score every (track, detection) pair against the predicted box
+  std::vector<std::tuple<float, int, int>> pairs;
+  for (int i = 0; i < tracks_.size(); i++) {
+    DetectionRatio predicted = tracks_[i].predict();
+    for (int j = 0; j < detections.size(); j++) {
+      float iou = predicted.iou(detections[j]);
+      if (iou >= cfg.min_matching_iou) pairs.emplace_back(iou, i, j);
+    }
+  }
+  std::sort(pairs.begin(), pairs.end(),
+            [](const std::tuple<float, int, int> &a,
+               const std::tuple<float, int, int> &b) {
+              return std::get<0>(a) > std::get<0>(b);
+            });
+
+  // greedy association, best overlap first
+  std::vector<bool> track_matched(tracks_.size(), false);
+  for (auto &pair : pairs) {
+    int i = std::get<1>(pair);
+    int j = std::get<2>(pair);
+    if (track_matched[i] || track_ids[j] != 0) continue;
+    track_matched[i] = true;
+
+    FaceTrack &track = tracks_[i];
+    DetectionRatio detection = detections[j];
+
+    // same rule as before: consecutive measurements should overlap well
+    if (track.detection.iou(detection) >= cfg.min_tracking_iou)
+      track.stable_counter++;
+    else
+      track.stable_counter = 0;
+
+    float steps = track.lost_count + 1;
+    float delta[4] = {
+        (detection.x - track.detection.x) / steps,
+        (detection.y - track.detection.y) / steps,
+        (detection.width - track.detection.width) / steps,
+        (detection.height - track.detection.height) / steps,
+    };
+    for (int k = 0; k < 4; k++)
+      track.velocity[k] = 0.5f * track.velocity[k] + 0.5f * delta[k];
+
+    track.detection = detection;
+    track.lost_count = 0;
+    track_ids[j] = track.id;
+  }
+
+  // age unmatched tracks
+  std::vector<FaceTrack> alive;
+  for (int i = 0; i < tracks_.size(); i++) {
+    if (!track_matched[i] && ++tracks_[i].lost_count > cfg.max_tracking_lost)
+      continue;
+    alive.push_back(tracks_[i]);
+  }
+  tracks_.swap(alive);
+
+  // start new tracks for unmatched detections
+  for (int j = 0; j < detections.size(); j++) {
+    if (track_ids[j] != 0) continue;
+    if (tracks_.size() >= cfg.max_tracking_faces) {
+      // replace the track lost for the longest time, if any
+      auto oldest = std::max_element(
+          tracks_.begin(), tracks_.end(),
+          [](const FaceTrack &a, const FaceTrack &b) {
+            return a.lost_count < b.lost_count;
+          });
+      if (oldest == tracks_.end() || oldest->lost_count == 0) continue;
+      tracks_.erase(oldest);
+    }
+
+    FaceTrack track;
+    track.id = next_id_++;
+    if (next_id_ == 0) next_id_ = 1;
+    track.detection = detections[j];
+    std::fill(track.velocity, track.velocity + 4, 0.f);
+    track.lost_count = 0;
+    track.stable_counter = 0;
+    track.has_pose = false;
+    track.pose_age = 0;
+    tracks_.push_back(track);
+    track_ids[j] = track.id;
+  }
+}
+
+void FaceTracker::clear() { tracks_.clear(); }
+
+FaceTrack *FaceTracker::find(SZ_UINT32 track_id) {
+  for (auto &track : tracks_) {
+    if (track.id == track_id) return &track;
+  }
+  return nullptr;
+}
+
+bool FaceTracker::is_stable(SZ_UINT32 track_id) {
+  FaceTrack *track = find(track_id);
+  return track != nullptr &&
+         track->stable_counter >= Config::get_detect().min_tracking_number;
+}
+
+const std::vector<FaceTrack> &FaceTracker::tracks() const { return tracks_; }
@@ -0,0 +1,50 @@
+#ifndef FACE_TRACKER_H
+#define FACE_TRACKER_H
+
+#include <vector>
+
+#include "detection_data.hpp"
+#include "quface/common.hpp"
+
+namespace suanzi {
+
+struct FaceTrack {
+  SZ_UINT32 id;
+  DetectionRatio detection;
+  float velocity[4];  // x, y, width, height per frame
+  SZ_UINT32 lost_count;
+  SZ_UINT32 stable_counter;
+
+  // last estimated landmarks and head pose, reused while the face is still
+  bool has_pose;
+  DetectionRatio pose_detection;
+  SZ_UINT32 pose_age;
+
+  DetectionRatio predict() const;
+};
+
+// Keeps up to max_tracking_faces tracks alive across frames. Detections are
+// associated to tracks greedily by iou against a constant-velocity
+// prediction, unmatched detections start new tracks and tracks lost for more
+// than max_tracking_lost frames are dropped. Track id 0 is never used.
+class FaceTracker {
+ public:
+  FaceTracker();
+
+  // detections are ratio boxes, track_ids is filled in the same order
+  void update(const std::vector<DetectionRatio> &detections,
+              std::vector<SZ_UINT32> &track_ids);
+  void clear();
+
+  FaceTrack *find(SZ_UINT32 track_id);
+  bool is_stable(SZ_UINT32 track_id);
+  const std::vector<FaceTrack> &tracks() const;
+
+ private:
+  std::vector<FaceTrack> tracks_;
+  SZ_UINT32 next_id_;
+};
+
+}  // namespace suanzi
+
+#endif
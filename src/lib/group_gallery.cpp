@@ -0,0 +1,78 @@
+#include "group_gallery.hpp"
+
+#include <algorithm>
+
+#include <quface/logger.hpp>
+
+#include "config.hpp"
+
+using namespace suanzi;
+
+bool GroupGallery::enabled() { return databases().size() > 0; }
+
+FaceDatabasePtr GroupGallery::find(const std::string &group) {
+  update();
+  for (int i = 0; i < groups_.size(); i++) {
+    if (groups_[i] == group) return databases_[i];
+  }
+  return nullptr;
+}
+
+const std::vector<FaceDatabasePtr> &GroupGallery::databases() {
+  update();
+  return databases_;
+}
+
+SZ_RETCODE GroupGallery::query(const FaceFeature &feature,
+                               QueryResult &result) {
+  static std::vector<QueryResult> results;
+
+  SZ_RETCODE ret = SZ_RETCODE_EMPTY_DATABASE;
+  for (auto &database : databases()) {
+    results.clear();
+    if (database->query(feature, 1, results) != SZ_RETCODE_OK) continue;
+
+    if (ret != SZ_RETCODE_OK || results[0].score > result.score)
+      result = results[0];
+    ret = SZ_RETCODE_OK;
+  }
+  return ret;
+}
+
+void GroupGallery::add(SZ_UINT32 face_id, const FaceFeature &feature,
+                       float ratio) {
+  std::vector<SZ_UINT32> face_ids;
+  for (auto &database : databases()) {
+    face_ids.clear();
+    if (database->list(face_ids) != SZ_RETCODE_OK ||
+        std::find(face_ids.begin(), face_ids.end(), face_id) == face_ids.end())
+      continue;
+
+    database->add(face_id, feature, ratio);
+  }
+}
+
+bool GroupGallery::is_valid_name(const std::string &group) {
+  // group names end up in file names
+  return !group.empty() && group.find('/') == std::string::npos &&
+         group.find("..") == std::string::npos;
+}
+
+void GroupGallery::update() {
+  auto groups = Config::get_user().access_groups;
+  if (groups == configured_) return;
+
+  configured_ = groups;
+  groups_.clear();
+  databases_.clear();
+  for (auto &group : configured_) {
+    if (!is_valid_name(group)) {
+      SZ_LOG_WARN("Invalid access group name {}, ignored", group);
+      continue;
+    }
+
+    groups_.push_back(group);
+    databases_.push_back(
+        std::make_shared<FaceDatabase>("_GROUP_" + group + "_DB_"));
+  }
+}
@@ -0,0 +1,42 @@
+#ifndef GROUP_GALLERY_H
+#define GROUP_GALLERY_H
+
+#include <string>
+#include <vector>
+
+#include "quface_common.hpp"
+
+namespace suanzi {
+
+// Sub-indexes of the gallery, one face database per access group of this
+// terminal. With access groups configured only their people are searched,
+// people of other groups could never pass here anyway.
+class GroupGallery {
+ public:
+  bool enabled();
+
+  // database of a configured group, nullptr for other groups
+  FaceDatabasePtr find(const std::string &group);
+  const std::vector<FaceDatabasePtr> &databases();
+
+  // best match over all configured groups
+  SZ_RETCODE query(const FaceFeature &feature, QueryResult &result);
+
+  // updates the template of a person in the groups they belong to
+  void add(SZ_UINT32 face_id, const FaceFeature &feature, float ratio);
+
+  // group names without path separators or parent references
+  static bool is_valid_name(const std::string &group);
+
+ private:
+  // reopens the databases once the configured groups change
+  void update();
+
+  std::vector<std::string> configured_;
+  std::vector<std::string> groups_;
+  std::vector<FaceDatabasePtr> databases_;
+};
+
+}  // namespace suanzi
+
+#endif
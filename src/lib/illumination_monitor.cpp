@@ -0,0 +1,68 @@
+#include "illumination_monitor.hpp"
+
+#include <quface/logger.hpp>
+
+#include "config.hpp"
+
+using namespace suanzi;
+
+IlluminationMonitor::IlluminationMonitor()
+    : luminance_(0), has_luminance_(false), mode_(DUAL) {}
+
+IlluminationMonitor::Mode IlluminationMonitor::update(const MmzImage *bgr) {
+  auto cfg = Config::get_detect();
+  if (!cfg.select_modality) {
+    mode_ = DUAL;
+    return mode_;
+  }
+
+  // sparse mean of luma is enough for the scene level
+  const int step = 8;
+  long sum = 0;
+  int count = 0;
+  for (int y = 0; y < bgr->height; y += step) {
+    const SZ_BYTE *row = bgr->pData + y * bgr->width;
+    for (int x = 0; x < bgr->width; x += step, count++) sum += row[x];
+  }
+  if (count == 0) return mode_;
+
+  float luminance = sum * 1.f / count;
+  luminance_ = has_luminance_ ? 0.9f * luminance_ + 0.1f * luminance
+                              : luminance;
+  has_luminance_ = true;
+
+  Mode mode = mode_;
+  float margin = cfg.luminance_hysteresis;
+  switch (mode_) {
+    case DUAL:
+      if (luminance_ < cfg.dark_luminance - margin)
+        mode = NIR_PRIMARY;
+      else if (luminance_ > cfg.bright_luminance + margin)
+        mode = BGR_ONLY;
+      break;
+    case BGR_ONLY:
+      if (luminance_ < cfg.bright_luminance - margin) mode = DUAL;
+      break;
+    case NIR_PRIMARY:
+      if (luminance_ > cfg.dark_luminance + margin) mode = DUAL;
+      break;
+  }
+
+  if (mode != mode_) {
+    SZ_LOG_INFO("luminance={:.1f}, mode {} --> {}", luminance_,
+                mode_name(mode_), mode_name(mode));
+    mode_ = mode;
+  }
+  return mode_;
+}
+
+const char *IlluminationMonitor::mode_name(Mode mode) {
+  switch (mode) {
+    case BGR_ONLY:
+      return "bgr_only";
+    case NIR_PRIMARY:
+      return "nir_primary";
+    default:
+      return "dual";
+  }
+}
@@ -0,0 +1,35 @@
+#ifndef ILLUMINATION_MONITOR_H
+#define ILLUMINATION_MONITOR_H
+
+#include <quface-io/mmzimage.hpp>
+
+namespace suanzi {
+using namespace io;
+
+// Estimates scene luminance from the luma plane of the small bgr image and
+// picks which modalities are worth detecting. Modes switch with hysteresis
+// around dark_luminance and bright_luminance so that a flickering scene does
+// not toggle the pipeline every frame.
+class IlluminationMonitor {
+ public:
+  typedef enum {
+    DUAL,         // bgr and nir
+    BGR_ONLY,     // good light, nir only while liveness needs it
+    NIR_PRIMARY,  // darkness, bgr only once nir sees a face
+  } Mode;
+
+  IlluminationMonitor();
+
+  Mode update(const MmzImage *bgr);
+
+  static const char *mode_name(Mode mode);
+
+ private:
+  float luminance_;
+  bool has_luminance_;
+  Mode mode_;
+};
+
+}  // namespace suanzi
+
+#endif
@@ -2,35 +2,46 @@
 
 using namespace suanzi;
 
-ImagePackage::ImagePackage() { frame_idx = 0; }
+ImagePackage::ImagePackage() {
+  frame_idx = 0;
+  has_large = true;
+}
 
 ImagePackage::ImagePackage(const ImagePackage* pkg) {
+  // models run on face chips, large images are only needed for hd snapshots
+  // and allocated by the first copy with them
   img_bgr_small = new MmzImage(pkg->img_bgr_small->width,
                                pkg->img_bgr_small->height, SZ_IMAGETYPE_NV21);
-  img_bgr_large = new MmzImage(pkg->img_bgr_large->width,
-                               pkg->img_bgr_large->height, SZ_IMAGETYPE_NV21);
+  img_bgr_large = nullptr;
 
   img_nir_small = new MmzImage(pkg->img_nir_small->width,
                                pkg->img_nir_small->height, SZ_IMAGETYPE_NV21);
-  img_nir_large = new MmzImage(pkg->img_nir_large->width,
-                               pkg->img_nir_large->height, SZ_IMAGETYPE_NV21);
+  img_nir_large = nullptr;
 
   frame_idx = pkg->frame_idx;
+  has_large = pkg->has_large;
+  capture_clock = pkg->capture_clock;
 }
 
 ImagePackage::ImagePackage(Size size_bgr_large, Size size_bgr_small,
                            Size size_nir_large, Size size_nir_small) {
   img_bgr_small = new MmzImage(size_bgr_small.width, size_bgr_small.height,
                                SZ_IMAGETYPE_NV21);
-  img_bgr_large = new MmzImage(size_bgr_large.width, size_bgr_large.height,
-                               SZ_IMAGETYPE_NV21);
-
   img_nir_small = new MmzImage(size_nir_small.width, size_nir_small.height,
                                SZ_IMAGETYPE_NV21);
-  img_nir_large = new MmzImage(size_nir_large.width, size_nir_large.height,
-                               SZ_IMAGETYPE_NV21);
+
+  // large images of zero size are allocated by the first copy with them
+  img_bgr_large = nullptr;
+  if (size_bgr_large.width > 0 && size_bgr_large.height > 0)
+    img_bgr_large = new MmzImage(size_bgr_large.width, size_bgr_large.height,
+                                 SZ_IMAGETYPE_NV21);
+  img_nir_large = nullptr;
+  if (size_nir_large.width > 0 && size_nir_large.height > 0)
+    img_nir_large = new MmzImage(size_nir_large.width, size_nir_large.height,
+                                 SZ_IMAGETYPE_NV21);
 
   frame_idx = 0;
+  has_large = true;
 }
 
 ImagePackage::~ImagePackage() {
@@ -40,11 +51,22 @@ ImagePackage::~ImagePackage() {
   if (img_nir_large) delete img_nir_large;
 }
 
-void ImagePackage::copy_to(ImagePackage& pkg) {
-  img_bgr_large->copy_to(*pkg.img_bgr_large);
+void ImagePackage::copy_to(ImagePackage& pkg, bool with_large) {
+  with_large = with_large && has_large;
+  if (with_large) {
+    if (pkg.img_bgr_large == nullptr)
+      pkg.img_bgr_large = new MmzImage(
+          img_bgr_large->width, img_bgr_large->height, SZ_IMAGETYPE_NV21);
+    if (pkg.img_nir_large == nullptr)
+      pkg.img_nir_large = new MmzImage(
+          img_nir_large->width, img_nir_large->height, SZ_IMAGETYPE_NV21);
+    img_bgr_large->copy_to(*pkg.img_bgr_large);
+    img_nir_large->copy_to(*pkg.img_nir_large);
+  }
   img_bgr_small->copy_to(*pkg.img_bgr_small);
-  img_nir_large->copy_to(*pkg.img_nir_large);
   img_nir_small->copy_to(*pkg.img_nir_small);
 
   pkg.frame_idx = frame_idx;
+  pkg.has_large = with_large;
+  pkg.capture_clock = capture_clock;
 }
@@ -2,6 +2,7 @@
 #define IMAGE_PACKAGE_H
 
 #include <QMetaType>
+#include <chrono>
 
 #include <opencv2/opencv.hpp>
 
@@ -20,10 +21,12 @@ class ImagePackage {
                Size size_nir_small);
   ~ImagePackage();
 
-  void copy_to(ImagePackage &pkg);
+  void copy_to(ImagePackage &pkg, bool with_large = true);
 
  public:
   int frame_idx;
+  bool has_large;
+  std::chrono::steady_clock::time_point capture_clock;
   MmzImage *img_bgr_small;
   MmzImage *img_bgr_large;
   MmzImage *img_nir_small;
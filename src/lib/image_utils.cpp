@@ -0,0 +1,40 @@
+#include "image_utils.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace suanzi;
+
+void ImageUtils::crop_nv21(const MmzImage *image, int x, int y, int width,
+                           int height, MmzImage *roi) {
+  roi->set_size(width, height);
+
+  // y plane
+  const SZ_BYTE *src = image->pData;
+  SZ_BYTE *dst = roi->pData;
+  for (int i = 0; i < height; i++)
+    memcpy(dst + i * width, src + (y + i) * image->width + x, width);
+
+  // interleaved vu plane at half height
+  src += image->width * image->height;
+  dst += width * height;
+  for (int i = 0; i < height / 2; i++)
+    memcpy(dst + i * width, src + (y / 2 + i) * image->width + x, width);
+}
+
+bool ImageUtils::align_region(const MmzImage *image, float padding, int &x,
+                              int &y, int &width, int &height) {
+  int x1 = std::max(0, (int)(x - width * padding));
+  int y1 = std::max(0, (int)(y - height * padding));
+  int x2 = std::min(image->width, (int)(x + width * (1 + padding)));
+  int y2 = std::min(image->height, (int)(y + height * (1 + padding)));
+  if (x2 <= x1 || y2 <= y1) return false;
+
+  x = x1 & ~1;
+  y = y1 & ~1;
+  width = std::min((x2 - x + 15) & ~15, image->width & ~15);
+  height = (y2 - y + 1) & ~1;
+  if (x + width > image->width) x = (image->width - width) & ~1;
+  if (y + height > image->height) height = (image->height - y) & ~1;
+  return width > 0 && height > 0;
+}
@@ -0,0 +1,24 @@
+#ifndef IMAGE_UTILS_H
+#define IMAGE_UTILS_H
+
+#include <quface-io/mmzimage.hpp>
+
+namespace suanzi {
+using namespace io;
+
+class ImageUtils {
+ public:
+  // copy a region of a NV21 image, x and y should be even and width aligned
+  // as the consumer of roi requires
+  static void crop_nv21(const MmzImage *image, int x, int y, int width,
+                        int height, MmzImage *roi);
+
+  // expand the region by padding on each side, align it for NV21 and clamp
+  // it inside the image. Returns false if nothing is left.
+  static bool align_region(const MmzImage *image, float padding, int &x,
+                           int &y, int &width, int &height);
+};
+
+}  // namespace suanzi
+
+#endif
@@ -0,0 +1,65 @@
+#include "latency_governor.hpp"
+
+#include <quface/logger.hpp>
+
+#include "config.hpp"
+
+using namespace suanzi;
+
+LatencyGovernor *LatencyGovernor::get_instance() {
+  static LatencyGovernor instance;
+  return &instance;
+}
+
+LatencyGovernor::LatencyGovernor()
+    : level_(NORMAL),
+      perf_counter_("LatencyGovernor"),
+      window_ms_(0),
+      window_count_(0) {}
+
+bool LatencyGovernor::degraded(Level level) {
+  return Config::get_app().latency_governor &&
+         get_instance()->level_ >= level;
+}
+
+void LatencyGovernor::add(const std::string &stage, float ms, bool is_last) {
+  const auto &cfg = Config::get_app();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  perf_counter_.add(std::string(level_name(level_)) + " " + stage, ms);
+  if (!is_last || !cfg.latency_governor) return;
+
+  window_ms_ += ms;
+  if (++window_count_ < cfg.governor_window) return;
+
+  // degrade one level at a time, recover with some headroom
+  float average = window_ms_ / window_count_;
+  int level = level_;
+  if (average > cfg.target_latency_ms && level < LEVELS - 1)
+    level++;
+  else if (average < cfg.target_latency_ms * 0.7 && level > NORMAL)
+    level--;
+  window_ms_ = 0;
+  window_count_ = 0;
+
+  if (level != level_) {
+    SZ_LOG_INFO("latency={:.1f}ms, target={}ms, level {} --> {}", average,
+                cfg.target_latency_ms, level_name(level_), level_name(level));
+    level_ = level;
+  }
+}
+
+const char *LatencyGovernor::level_name(int level) {
+  switch (level) {
+    case SKIP_NIR:
+      return "skip_nir";
+    case LOWER_DETECTION:
+      return "lower_detection";
+    case SKIP_POSE:
+      return "skip_pose";
+    case DEFER_SNAPSHOT:
+      return "defer_snapshot";
+    default:
+      return "normal";
+  }
+}
@@ -0,0 +1,49 @@
+#ifndef LATENCY_GOVERNOR_H
+#define LATENCY_GOVERNOR_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include "perf_counter.hpp"
+
+namespace suanzi {
+
+// Keeps the end to end frame latency under target_latency_ms by stepping
+// through degradation levels, one per governor_window frames, and stepping
+// back once the average latency leaves enough headroom. Each level keeps the
+// degradations of the lower ones. Stage latencies since capture are reported
+// per level for tuning.
+class LatencyGovernor {
+ public:
+  typedef enum {
+    NORMAL,
+    SKIP_NIR,         // nir only while liveness is pending
+    LOWER_DETECTION,  // detect every other frame
+    SKIP_POSE,        // no pose refresh on stable tracks
+    DEFER_SNAPSHOT,   // snapshot from the deciding frame only
+    LEVELS,
+  } Level;
+
+  static LatencyGovernor *get_instance();
+
+  // latency of a stage since capture, the last stage drives the level
+  void add(const std::string &stage, float ms, bool is_last = false);
+
+  static bool degraded(Level level);
+
+ private:
+  LatencyGovernor();
+
+  static const char *level_name(int level);
+
+  std::atomic_int level_;
+  std::mutex mutex_;
+  PerfCounter perf_counter_;
+  float window_ms_;
+  int window_count_;
+};
+
+}  // namespace suanzi
+
+#endif
@@ -0,0 +1,113 @@
+#include "nir_mapping.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace suanzi;
+
+NirMapping::NirMapping() { clear(); }
+
+void NirMapping::clear() {
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) ata_[i][j] = 0;
+    atx_[i] = aty_[i] = 0;
+  }
+  xx_ = yy_ = 0;
+  point_count_ = 0;
+  sample_count_ = 0;
+}
+
+int NirMapping::sample_count() const { return sample_count_; }
+
+void NirMapping::add_point(float x, float y, float nir_x, float nir_y) {
+  double row[3] = {x, y, 1};
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) ata_[i][j] += row[i] * row[j];
+    atx_[i] += row[i] * nir_x;
+    aty_[i] += row[i] * nir_y;
+  }
+  xx_ += nir_x * nir_x;
+  yy_ += nir_y * nir_y;
+  point_count_++;
+}
+
+void NirMapping::add_sample(const DetectionRatio &bgr,
+                            const DetectionRatio &nir) {
+  add_point(bgr.x, bgr.y, nir.x, nir.y);
+  add_point(bgr.x + bgr.width, bgr.y + bgr.height, nir.x + nir.width,
+            nir.y + nir.height);
+  for (int i = 0; i < SZ_LANDMARK_NUM; i++)
+    add_point(bgr.landmark[i][0], bgr.landmark[i][1], nir.landmark[i][0],
+              nir.landmark[i][1]);
+  sample_count_++;
+}
+
+static double determinant(const double m[3][3]) {
+  return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+         m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+         m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+// Cramer's rule, returns the residual sum of squares
+static bool solve(const double ata[3][3], const double atb[3], double bb,
+                  double w[3], double &rss) {
+  double det = determinant(ata);
+  if (std::abs(det) < 1e-12) return false;
+
+  for (int k = 0; k < 3; k++) {
+    double m[3][3];
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) m[i][j] = j == k ? atb[i] : ata[i][j];
+    }
+    w[k] = determinant(m) / det;
+  }
+
+  // |Aw - b|^2 = w'A'Aw - 2 w'A'b + b'b
+  rss = bb;
+  for (int i = 0; i < 3; i++) {
+    rss -= 2 * w[i] * atb[i];
+    for (int j = 0; j < 3; j++) rss += w[i] * ata[i][j] * w[j];
+  }
+  return true;
+}
+
+bool NirMapping::fit(std::vector<SZ_FLOAT> &mapping) const {
+  if (point_count_ < 3) return false;
+
+  double wx[3], wy[3], rss_x, rss_y;
+  if (!solve(ata_, atx_, xx_, wx, rss_x) || !solve(ata_, aty_, yy_, wy, rss_y))
+    return false;
+
+  // both sensors look at the same scene, a mapping far from identity scale
+  // or with a large residual comes from mismatched faces
+  float rms = std::sqrt(std::max(rss_x + rss_y, 0.) / point_count_);
+  if (rms > 0.02 || wx[0] < 0.5 || wx[0] > 2 || wy[1] < 0.5 || wy[1] > 2)
+    return false;
+
+  mapping = {(SZ_FLOAT)wx[0], (SZ_FLOAT)wx[1], (SZ_FLOAT)wx[2],
+             (SZ_FLOAT)wy[0], (SZ_FLOAT)wy[1], (SZ_FLOAT)wy[2]};
+  return true;
+}
+
+bool NirMapping::map(const std::vector<SZ_FLOAT> &mapping,
+                     const DetectionRatio &bgr, DetectionRatio &nir) {
+  if (mapping.size() != 6) return false;
+
+  auto map_x = [&](float x, float y) {
+    return mapping[0] * x + mapping[1] * y + mapping[2];
+  };
+  auto map_y = [&](float x, float y) {
+    return mapping[3] * x + mapping[4] * y + mapping[5];
+  };
+
+  nir = bgr;
+  nir.x = map_x(bgr.x, bgr.y);
+  nir.y = map_y(bgr.x, bgr.y);
+  nir.width = map_x(bgr.x + bgr.width, bgr.y + bgr.height) - nir.x;
+  nir.height = map_y(bgr.x + bgr.width, bgr.y + bgr.height) - nir.y;
+  for (int i = 0; i < SZ_LANDMARK_NUM; i++) {
+    nir.landmark[i][0] = map_x(bgr.landmark[i][0], bgr.landmark[i][1]);
+    nir.landmark[i][1] = map_y(bgr.landmark[i][0], bgr.landmark[i][1]);
+  }
+  return nir.width > 0 && nir.height > 0;
+}
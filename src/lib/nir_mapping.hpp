@@ -0,0 +1,44 @@
+#ifndef NIR_MAPPING_H
+#define NIR_MAPPING_H
+
+#include <vector>
+
+#include "detection_data.hpp"
+
+namespace suanzi {
+
+// Affine mapping from bgr to nir ratio coordinates, fitted by least squares
+// on the landmarks and box corners of faces detected on both sensors. Once
+// fitted it is stored with the infrared camera config, so the nir face can
+// be predicted from the bgr face instead of being detected.
+class NirMapping {
+ public:
+  NirMapping();
+
+  void add_sample(const DetectionRatio &bgr, const DetectionRatio &nir);
+  int sample_count() const;
+  void clear();
+
+  // fits [a, b, c, d, e, f] with nir_x = a x + b y + c, nir_y = d x + e y + f,
+  // fails if the sensors don't agree on an affine mapping
+  bool fit(std::vector<SZ_FLOAT> &mapping) const;
+
+  static bool map(const std::vector<SZ_FLOAT> &mapping,
+                  const DetectionRatio &bgr, DetectionRatio &nir);
+
+ private:
+  void add_point(float x, float y, float nir_x, float nir_y);
+
+  // normal equations, shared by both output coordinates
+  double ata_[3][3];
+  double atx_[3];
+  double aty_[3];
+  double xx_;
+  double yy_;
+  int point_count_;
+  int sample_count_;
+};
+
+}  // namespace suanzi
+
+#endif
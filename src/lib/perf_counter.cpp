@@ -0,0 +1,47 @@
+#include "perf_counter.hpp"
+
+#include <algorithm>
+
+#include <quface/logger.hpp>
+
+using namespace suanzi;
+
+PerfCounter::PerfCounter(const std::string &name, int report_interval)
+    : name_(name),
+      report_interval_(report_interval),
+      last_report_clock_(std::chrono::steady_clock::now()) {}
+
+void PerfCounter::add(const std::string &key, float ms) {
+  auto &entry = entries_[key];
+  entry.count++;
+  entry.total_ms += ms;
+  entry.max_ms = std::max(entry.max_ms, ms);
+
+  auto now = std::chrono::steady_clock::now();
+  if (std::chrono::duration_cast<std::chrono::seconds>(now -
+                                                       last_report_clock_)
+          .count() >= report_interval_) {
+    report();
+    last_report_clock_ = now;
+  }
+}
+
+float PerfCounter::elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         1000.f;
+}
+
+void PerfCounter::report() {
+  int total = 0;
+  for (auto &it : entries_) total += it.second.count;
+
+  for (auto &it : entries_) {
+    auto &entry = it.second;
+    SZ_LOG_INFO("{} {}: count={} ({:.1f}%), avg={:.2f}ms, max={:.2f}ms", name_,
+                it.first, entry.count, entry.count * 100.f / total,
+                entry.total_ms / entry.count, entry.max_ms);
+  }
+  entries_.clear();
+}
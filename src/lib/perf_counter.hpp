@@ -0,0 +1,37 @@
+#ifndef PERF_COUNTER_H
+#define PERF_COUNTER_H
+
+#include <chrono>
+#include <map>
+#include <string>
+
+namespace suanzi {
+
+// Counts runs and accumulates time per key, logs the summary every
+// report_interval seconds and starts over.
+class PerfCounter {
+ public:
+  PerfCounter(const std::string &name, int report_interval = 10);
+
+  void add(const std::string &key, float ms);
+
+  static float elapsed_ms(std::chrono::steady_clock::time_point start);
+
+ private:
+  typedef struct {
+    int count;
+    float total_ms;
+    float max_ms;
+  } Entry;
+
+  void report();
+
+  std::string name_;
+  int report_interval_;
+  std::chrono::steady_clock::time_point last_report_clock_;
+  std::map<std::string, Entry> entries_;
+};
+
+}  // namespace suanzi
+
+#endif
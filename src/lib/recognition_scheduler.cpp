@@ -0,0 +1,60 @@
+#include "recognition_scheduler.hpp"
+
+#include <algorithm>
+
+#include "config.hpp"
+#include "face_quality.hpp"
+
+using namespace suanzi;
+
+RecognitionScheduler::RecognitionScheduler() {}
+
+int RecognitionScheduler::schedule(const MmzImage *image,
+                                   const std::vector<TrackedFace> &faces) {
+  auto cfg = Config::get_detect();
+
+  int count = std::min((int)faces.size(), std::max(cfg.max_candidate_faces, 1));
+
+  // forget faces which are no longer candidates
+  std::map<SZ_UINT32, Candidate> candidates;
+  for (int i = 0; i < count; i++) {
+    auto it = candidates_.find(faces[i].track_id);
+    if (it != candidates_.end())
+      candidates[it->first] = it->second;
+    else
+      candidates[faces[i].track_id] = {0, false};
+  }
+  candidates_.swap(candidates);
+
+  // a single candidate needs no scoring
+  if (count == 1) return faces[0].valid ? 0 : -1;
+
+  int selected = -1;
+  float best_priority = 0;
+  for (int i = 0; i < count; i++) {
+    if (!faces[i].valid) continue;
+
+    DetectionRatio detection = faces[i].detection;
+    Candidate &candidate = candidates_[faces[i].track_id];
+    float priority = detection.width / faces[0].detection.width +
+                     FaceQuality::evaluate(image, detection) +
+                     cfg.schedule_wait_weight * candidate.waited;
+    if (candidate.identified) priority -= cfg.schedule_identified_penalty;
+
+    if (selected < 0 || priority > best_priority) {
+      selected = i;
+      best_priority = priority;
+    }
+  }
+  return selected;
+}
+
+void RecognitionScheduler::served(SZ_UINT32 track_id) {
+  for (auto &it : candidates_)
+    it.second.waited = it.first == track_id ? 0 : it.second.waited + 1;
+}
+
+void RecognitionScheduler::set_identified(SZ_UINT32 track_id) {
+  auto it = candidates_.find(track_id);
+  if (it != candidates_.end()) it->second.identified = true;
+}
@@ -0,0 +1,45 @@
+#ifndef RECOGNITION_SCHEDULER_H
+#define RECOGNITION_SCHEDULER_H
+
+#include <map>
+#include <vector>
+
+#include <quface-io/mmzimage.hpp>
+
+#include "detection_data.hpp"
+#include "quface/common.hpp"
+
+namespace suanzi {
+using namespace io;
+
+// Shares the recognition slot of each frame among up to max_candidate_faces
+// valid faces. Priority grows with face size, quality and the frames waited
+// since the face was last served, and drops once the face is identified, so
+// that the person at the door is served most often without starving the
+// others in a queue.
+class RecognitionScheduler {
+ public:
+  RecognitionScheduler();
+
+  // faces are sorted largest first, returns the index of the face to
+  // recognize or -1 if none of the candidates is valid
+  int schedule(const MmzImage *image, const std::vector<TrackedFace> &faces);
+
+  // the scheduled face was handed to recognition, the others wait one more
+  // round. Frames dropped while recognition is busy don't count
+  void served(SZ_UINT32 track_id);
+
+  void set_identified(SZ_UINT32 track_id);
+
+ private:
+  typedef struct {
+    int waited;
+    bool identified;
+  } Candidate;
+
+  std::map<SZ_UINT32, Candidate> candidates_;
+};
+
+}  // namespace suanzi
+
+#endif
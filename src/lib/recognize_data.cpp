@@ -6,6 +6,9 @@ RecognizeData::RecognizeData() {
   is_live = false;
   person_info.score = 0;
   person_info.face_id = 0;
+  fused_count = 1;
+  identity_locked = false;
+  watchlist_hit = false;
 }
 
 RecognizeData::RecognizeData(Size size_bgr_large, Size size_bgr_small,
@@ -18,6 +21,9 @@ RecognizeData::RecognizeData(Size size_bgr_large, Size size_bgr_small,
   has_person_info = false;
   person_info.score = 0;
   person_info.face_id = 0;
+  fused_count = 1;
+  identity_locked = false;
+  watchlist_hit = false;
 }
 
 RecognizeData::~RecognizeData() {}
@@ -23,6 +23,15 @@ class RecognizeData : public DetectionData {
   QueryResult person_info;
   FaceFeature person_feature;
   bool has_mask;
+
+  // number of frames fused into person_feature, each counts as a vote
+  int fused_count;
+
+  // person info is reused from an identity confirmed earlier on this track
+  bool identity_locked;
+
+  // person info comes from the watchlist, alerted without voting
+  bool watchlist_hit;
 };
 
 }  // namespace suanzi
@@ -0,0 +1,29 @@
+#include "sequential_test.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace suanzi;
+
+SequentialTest::SequentialTest(float false_accept_rate,
+                               float false_reject_rate, int max_length,
+                               bool symmetric)
+    : max_length_(max_length), symmetric_(symmetric) {
+  float alpha = std::min(std::max(false_accept_rate, 1e-6f), 0.5f);
+  float beta = std::min(std::max(false_reject_rate, 1e-6f), 0.5f);
+  upper_ = std::log((1 - beta) / alpha);
+  lower_ = std::log(beta / (1 - alpha));
+}
+
+SequentialTest::Decision SequentialTest::decide(float llr, int length) const {
+  if (llr >= upper_) return ACCEPT;
+  if (llr <= lower_) return REJECT;
+  if (length >= max_length_) return symmetric_ && llr > 0 ? ACCEPT : REJECT;
+  return UNDECIDED;
+}
+
+float SequentialTest::binary_llr(bool observation, float accuracy) {
+  accuracy = std::min(std::max(accuracy, 0.5f), 0.999f);
+  float llr = std::log(accuracy / (1 - accuracy));
+  return observation ? llr : -llr;
+}
@@ -0,0 +1,38 @@
+#ifndef SEQUENTIAL_TEST_H
+#define SEQUENTIAL_TEST_H
+
+namespace suanzi {
+
+// Wald's sequential probability ratio test. Per frame evidence is summed as a
+// log-likelihood ratio and the hypothesis is accepted or rejected as soon as
+// the sum crosses the bounds derived from the tolerated error rates. Once
+// max_length frames are seen without reaching a bound the hypothesis is
+// rejected, so weak but steady evidence can't bypass the false accept rate.
+// Symmetric tests, where both outcomes are equally acceptable, are truncated
+// by the sign of the sum instead.
+class SequentialTest {
+ public:
+  typedef enum {
+    UNDECIDED,
+    ACCEPT,
+    REJECT,
+  } Decision;
+
+  SequentialTest(float false_accept_rate, float false_reject_rate,
+                 int max_length, bool symmetric = false);
+
+  Decision decide(float llr, int length) const;
+
+  // evidence of a binary classifier with the given accuracy
+  static float binary_llr(bool observation, float accuracy);
+
+ private:
+  float upper_;
+  float lower_;
+  int max_length_;
+  bool symmetric_;
+};
+
+}  // namespace suanzi
+
+#endif
@@ -0,0 +1,43 @@
+#include "tile_scheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace suanzi;
+
+TileScheduler::TileScheduler()
+    : tile_count_(0), scan_index_(0), target_index_(0) {}
+
+static int grid_size(int length, int tile_length) {
+  // a quarter of overlap between neighbour tiles
+  if (length <= tile_length) return 1;
+  return (int)std::ceil((length - tile_length) / (tile_length * 0.75f)) + 1;
+}
+
+void TileScheduler::next(int image_width, int image_height, int tile_width,
+                         int tile_height,
+                         const std::vector<DetectionRatio> &targets, int &x,
+                         int &y) {
+  int max_x = std::max(image_width - tile_width, 0);
+  int max_y = std::max(image_height - tile_height, 0);
+
+  if (targets.size() > 0 && tile_count_++ % 2 == 0) {
+    // tile centered on a target
+    const DetectionRatio &target = targets[target_index_++ % targets.size()];
+    x = (target.x + target.width / 2) * image_width - tile_width / 2;
+    y = (target.y + target.height / 2) * image_height - tile_height / 2;
+  } else {
+    int cols = grid_size(image_width, tile_width);
+    int rows = grid_size(image_height, tile_height);
+    int index = scan_index_++ % (cols * rows);
+    scan_index_ %= cols * rows;
+
+    int col = index % cols;
+    int row = index / cols;
+    x = cols > 1 ? max_x * col / (cols - 1) : 0;
+    y = rows > 1 ? max_y * row / (rows - 1) : 0;
+  }
+
+  x = std::min(std::max(x, 0), max_x) & ~1;
+  y = std::min(std::max(y, 0), max_y) & ~1;
+}
@@ -0,0 +1,32 @@
+#ifndef TILE_SCHEDULER_H
+#define TILE_SCHEDULER_H
+
+#include <vector>
+
+#include "detection_data.hpp"
+
+namespace suanzi {
+
+// Picks the tiles of a large image the detector looks at, a few per frame.
+// Tiles alternate between following known targets, so that they stay
+// tracked, and scanning an overlapping grid over the whole image, so that
+// new faces are found within one sweep.
+class TileScheduler {
+ public:
+  TileScheduler();
+
+  // targets are ratio boxes, x and y are the even top left corner of the
+  // tile in pixels
+  void next(int image_width, int image_height, int tile_width,
+            int tile_height, const std::vector<DetectionRatio> &targets,
+            int &x, int &y);
+
+ private:
+  int tile_count_;
+  int scan_index_;
+  int target_index_;
+};
+
+}  // namespace suanzi
+
+#endif
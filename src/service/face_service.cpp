@@ -33,6 +33,14 @@ void suanzi::from_json(const json &j, PersonImageInfo &p) {
   if (j.contains("faceImage")) {
     j.at("faceImage").get_to(p.face_image);
   }
+
+  if (j.contains("status")) {
+    j.at("status").get_to(p.status);
+  }
+
+  if (j.contains("groups")) {
+    j.at("groups").get_to(p.groups);
+  }
 }
 
 using namespace suanzi;
@@ -43,6 +51,8 @@ FaceService::FaceService(PersonService::ptr person_service, bool store_image)
       store_image_(store_image) {
   auto quface = Config::get_quface();
   face_database_ = std::make_shared<FaceDatabase>(quface.db_name);
+  watchlist_database_ = std::make_shared<FaceDatabase>("_WATCHLIST_DB_");
+  recent_database_ = std::make_shared<FaceDatabase>("_RECENT_DB_");
 
   detector_ = std::make_shared<FaceDetector>(quface.model_file_path);
   extractor_ = std::make_shared<FaceExtractor>(quface.model_file_path);
@@ -216,6 +226,52 @@ SZ_RETCODE FaceService::read_image_as_base64(SZ_UINT32 id,
   return SZ_RETCODE_FAILED;
 }
 
+SZ_RETCODE FaceService::update_watchlist(const PersonImageInfo &face,
+                                         const FaceFeature &feature) {
+  std::string status = face.status;
+  if (status.empty()) {
+    PersonData person;
+    if (person_service_->get_person(face.id, person) == SZ_RETCODE_OK)
+      status = person.status;
+  }
+
+  // a status change moves the person in or out of the watchlist
+  if (status == PersonService::get_status(PersonStatus::Blacklist)) {
+    SZ_LOG_INFO("Watchlist add id: {}", face.id);
+    return watchlist_database_->add(face.id, feature);
+  }
+  watchlist_database_->remove(face.id);
+  return SZ_RETCODE_OK;
+}
+
+SZ_RETCODE FaceService::update_groups(const PersonImageInfo &face,
+                                      const FaceFeature &feature) {
+  // only groups admitted by this terminal have a sub-index
+  for (auto &group : Config::get_user().access_groups) {
+    auto database = group_gallery_.find(group);
+    if (database == nullptr) continue;
+
+    if (std::find(face.groups.begin(), face.groups.end(), group) ==
+        face.groups.end()) {
+      database->remove(face.id);
+      continue;
+    }
+
+    SZ_RETCODE ret = database->add(face.id, feature);
+    if (ret != SZ_RETCODE_OK) return ret;
+  }
+  return SZ_RETCODE_OK;
+}
+
+SZ_RETCODE FaceService::save_databases() {
+  SZ_RETCODE ret = face_database_->save();
+  if (ret == SZ_RETCODE_OK) ret = watchlist_database_->save();
+  for (auto &database : group_gallery_.databases()) {
+    if (ret == SZ_RETCODE_OK) ret = database->save();
+  }
+  return ret;
+}
+
 SZ_RETCODE FaceService::read_buffer(const PersonImageInfo &face,
                                     std::vector<SZ_BYTE> &buffer) {
   buffer.clear();
@@ -293,6 +349,18 @@ json FaceService::db_add(const json &body) {
       };
     }
 
+    recent_database_->remove(face.id);
+    ret = update_watchlist(face, feature);
+    if (ret == SZ_RETCODE_OK) ret = update_groups(face, feature);
+    if (ret != SZ_RETCODE_OK) {
+      SZ_LOG_ERROR("update_watchlist or update_groups failed");
+      return {
+          {"ok", false},
+          {"message", "update sub-index failed"},
+          {"code", "DB_FAILED"},
+      };
+    }
+
     ret = person_service_->update_person_face_image(face.id, buffer);
     if (ret != SZ_RETCODE_OK) {
       SZ_LOG_ERROR("update_person_face_image failed");
@@ -303,7 +371,7 @@ json FaceService::db_add(const json &body) {
       };
     }
 
-    ret = face_database_->save();
+    ret = save_databases();
     if (ret != SZ_RETCODE_OK) {
       SZ_LOG_ERROR("face_database_->save failed");
       return {
@@ -378,6 +446,17 @@ json FaceService::db_add_many(const json &body) {
         continue;
       }
 
+      recent_database_->remove(face.id);
+      ret = update_watchlist(face, feature);
+      if (ret == SZ_RETCODE_OK) ret = update_groups(face, feature);
+      if (ret != SZ_RETCODE_OK) {
+        failedPersons.push_back(
+            json({{"id", face.id}, {"reason", "DB_FAILED"}}));
+        SZ_LOG_WARN("[Add many] failed face id: {} reason: {}", face.id,
+                    "DB_FAILED");
+        continue;
+      }
+
       ret = person_service_->update_person_face_image(face.id, buffer);
       if (ret != SZ_RETCODE_OK) {
         failedPersons.push_back(
@@ -388,7 +467,7 @@ json FaceService::db_add_many(const json &body) {
       }
     }
 
-    ret = face_database_->save();
+    ret = save_databases();
     if (ret != SZ_RETCODE_OK) {
       SZ_LOG_ERROR("[Add many] db.save failed");
       return {
@@ -430,7 +509,12 @@ json FaceService::db_remove_by_id(const json &body) {
     };
   }
 
-  ret = face_database_->save();
+  // most people are not on the watchlist or in every group
+  watchlist_database_->remove(face_id);
+  recent_database_->remove(face_id);
+  for (auto &database : group_gallery_.databases()) database->remove(face_id);
+
+  ret = save_databases();
   if (ret != SZ_RETCODE_OK) {
     SZ_LOG_ERROR("db.save failed");
     return {
@@ -446,6 +530,11 @@ json FaceService::db_remove_by_id(const json &body) {
 json FaceService::db_remove_all(const json &body) {
   SZ_LOG_DEBUG("db.remove_all");
   SZ_RETCODE ret = face_database_->clear();
+  if (ret == SZ_RETCODE_OK) ret = watchlist_database_->clear();
+  recent_database_->clear();
+  for (auto &database : group_gallery_.databases()) {
+    if (ret == SZ_RETCODE_OK) ret = database->clear();
+  }
   if (ret != SZ_RETCODE_OK) {
     SZ_LOG_ERROR("db.clear failed");
     return {
@@ -455,7 +544,7 @@ json FaceService::db_remove_all(const json &body) {
     };
   }
 
-  ret = face_database_->save();
+  ret = save_databases();
   if (ret != SZ_RETCODE_OK) {
     SZ_LOG_ERROR("db.save failed");
     return {
@@ -521,6 +610,8 @@ json FaceService::db_get_all(const json &body) {
         .face_url = "",
         .face_path = "",
         .face_image = faceBase64,
+        .status = "",
+        .groups = {},
     });
   }
 
@@ -2,6 +2,7 @@
 
 #include <nlohmann/json.hpp>
 
+#include "group_gallery.hpp"
 #include "person_service.hpp"
 #include "quface_common.hpp"
 
@@ -13,6 +14,12 @@ struct PersonImageInfo {
   std::string face_url;
   std::string face_path;
   std::string face_image;
+
+  // optional, looked up from PersonService when missing
+  std::string status;
+
+  // access groups of the person, searched by terminals admitting them
+  std::vector<std::string> groups;
 };
 
 void to_json(json &j, const PersonImageInfo &p);
@@ -45,8 +52,22 @@ class FaceService {
                                    FaceFeature &feature,
                                    std::string &error_message);
   SZ_RETCODE read_image_as_base64(SZ_UINT32 id, std::string &result);
+  SZ_RETCODE update_watchlist(const PersonImageInfo &face,
+                              const FaceFeature &feature);
+  SZ_RETCODE update_groups(const PersonImageInfo &face,
+                           const FaceFeature &feature);
+  SZ_RETCODE save_databases();
 
   FaceDatabasePtr face_database_;
+  // blacklisted people, kept in step by db_add and db_add_many only. People
+  // enrolled before it existed or blacklisted later through PersonService
+  // join it once they are synced again.
+  FaceDatabasePtr watchlist_database_;
+
+  // in-memory templates of RecognizeTask's re-entry cache, dropped when the
+  // person is removed or enrolled again
+  FaceDatabasePtr recent_database_;
+  GroupGallery group_gallery_;
   FaceDetectorPtr detector_;
   FacePoseEstimatorPtr pose_estimator_;
   FaceExtractorPtr extractor_;
@@ -59,6 +59,14 @@ void VideoPlayer::init_workflow() {
           (const QObject *)recognize_task_, SLOT(rx_nir_finish(bool)));
   connect((const QObject *)record_task_, SIGNAL(tx_bgr_finish(bool)),
           (const QObject *)recognize_task_, SLOT(rx_bgr_finish(bool)));
+  connect((const QObject *)record_task_, SIGNAL(tx_identity(uint, uint)),
+          (const QObject *)recognize_task_, SLOT(rx_identity(uint, uint)));
+  connect((const QObject *)record_task_, SIGNAL(tx_identity(uint, uint)),
+          (const QObject *)detect_task_, SLOT(rx_identity(uint, uint)));
+  connect((const QObject *)record_task_, SIGNAL(tx_liveness(uint, bool)),
+          (const QObject *)recognize_task_, SLOT(rx_liveness(uint, bool)));
+  connect((const QObject *)record_task_, SIGNAL(tx_mask(uint, bool)),
+          (const QObject *)recognize_task_, SLOT(rx_mask(uint, bool)));
 
   // 创建继电器开关线程
   gpio_task_ = GPIOTask::get_instance();